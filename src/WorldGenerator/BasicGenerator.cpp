@@ -17,21 +17,18 @@ namespace WorldBuilder {
         Vec3 randomPoint = this->randomSource->getRandomPointUnitSphere();
         auto plateIt = theWorld->get_plates().find(0);
         if (plateIt != theWorld->get_plates().end()) {
-            for (auto cellIt = plateIt->second->cells.begin();
-                 cellIt != plateIt->second->cells.end();
-                 cellIt++) {
-                std::shared_ptr<PlateCell> cell = cellIt->second;
+            for (auto&& cell : plateIt->second->cells) {
                 // could to distance square comparisions here
-                float distance = math::distanceBetween3Points(randomPoint, cell->get_vertex()->get_vector());
+                float distance = math::distanceBetween3Points(randomPoint, cell.get_vertex()->get_vector());
                 if (distance < landRadius) {
                     // basic land column
-                    cell->rock.continental.set_density(2700);
-                    cell->rock.continental.set_thickness(15000 + 10000*(landRadius-distance)/landRadius);
-                    cell->rock.root.set_density(3200);
-                    cell->rock.root.set_thickness(135000);
+                    cell.rock.continental.set_density(2700);
+                    cell.rock.continental.set_thickness(15000 + 10000*(landRadius-distance)/landRadius);
+                    cell.rock.root.set_density(3200);
+                    cell.rock.root.set_thickness(135000);
                 } else {
                     // create the world default column for newly divergent ocean crust
-                    cell->rock = theWorld->get_divergentOceanicColumn();
+                    cell.rock = theWorld->get_divergentOceanicColumn();
                 }
             }
         } else {
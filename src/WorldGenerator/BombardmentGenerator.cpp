@@ -22,16 +22,15 @@ namespace WorldBuilder {
         if (plateIt != theWorld->get_plates().end()) {
             std::shared_ptr<Plate> plate = plateIt->second;
             // start with a nice smooth world
-            for (auto&& cellIt : plate->cells)
+            for (auto&& cell : plate->cells)
             {
-                std::shared_ptr<PlateCell>& cell = cellIt.second;
-                cell->age = 11.0;
-                cell->rock.root.set_density(3200);
-                cell->rock.root.set_thickness(prehistoricRootThickness);
+                cell.age = 11.0;
+                cell.rock.root.set_density(3200);
+                cell.rock.root.set_thickness(prehistoricRootThickness);
 
                 // add some default cont thickness
-                cell->rock.continental.set_density(2700);
-                cell->rock.continental.set_thickness(2000);
+                cell.rock.continental.set_density(2700);
+                cell.rock.continental.set_thickness(2000);
             }
             
             // create our impact crater radii
@@ -77,24 +76,23 @@ namespace WorldBuilder {
                 // TODO, MAKE BETER!
                 size_t tilesWithin = 0;
                 size_t tilesWithout = 0;
-                for (auto&& cellIt : plate->cells)
+                for (auto&& cell : plate->cells)
                 {
-                    std::shared_ptr<PlateCell>& cell = cellIt.second;
-                    wb_float distance = math::distanceBetween3Points(randomCollisionLocation, cell->get_vertex()->get_vector());
+                    wb_float distance = math::distanceBetween3Points(randomCollisionLocation, cell.get_vertex()->get_vector());
                     // for now just remove material in a symetrical manner
                     if (distance < impactRadius) {
                         tilesWithin++;
                         distance = distance * theWorld->get_attributes().radius * 1000; // to meters
                         // 10^6 for km^2 to m^2
                         wb_float materialChange = -1*(distance*distance * 0.05 / craterRadius - (craterRadius * 0.05));
-                        if (materialChange > cell->rock.thickness()) {
-                            materialChange = cell->rock.thickness();
+                        if (materialChange > cell.rock.thickness()) {
+                            materialChange = cell.rock.thickness();
                         } else if (materialChange < 0){
                             std::printf("UH OH!!!");
                         }
-                        materialEjected = accreteColumns(materialEjected, cell->rock.removeThickness(materialChange));
+                        materialEjected = accreteColumns(materialEjected, cell.rock.removeThickness(materialChange));
                     } else if (distance < 2*impactRadius){
-                        ejectaCells.push_back(&*cell);
+                        ejectaCells.push_back(&cell);
                         tilesWithout++;
                     }
                 }
@@ -155,21 +153,20 @@ namespace WorldBuilder {
             }
             
             // flood low stuff with lava
-            for (auto&& cellIt : plate->cells)
+            for (auto&& cell : plate->cells)
             {
-                std::shared_ptr<PlateCell>& cell = cellIt.second;
                 
                 // remove any extra root thickness
-                wb_float meltToThickness = cell->rock.root.get_thickness() - 100000;
+                wb_float meltToThickness = cell.rock.root.get_thickness() - 100000;
                 // check to see if desired thickness is too small, may want to melt from other cells
                 if (meltToThickness < theWorld->get_divergentOceanicColumn().root.get_thickness()) {
                     meltToThickness = theWorld->get_divergentOceanicColumn().root.get_thickness();
                 }
-                cell->rock.root.set_thickness(meltToThickness);
+                cell.rock.root.set_thickness(meltToThickness);
                 
                 // fill in with laaava
-                if (cell->rock.thickness() < theWorld->get_divergentOceanicColumn().thickness()) {
-                    cell->rock = theWorld->get_divergentOceanicColumn();
+                if (cell.rock.thickness() < theWorld->get_divergentOceanicColumn().thickness()) {
+                    cell.rock = theWorld->get_divergentOceanicColumn();
                 }
             }
         } else { // plate zero not found
@@ -0,0 +1,151 @@
+// --
+//  DisplacementSolver.cpp
+//  WorldGenerator
+//
+
+
+#include "DisplacementSolver.hpp"
+
+#include <algorithm>
+
+namespace WorldBuilder {
+    // rows per chunk, chunk partial sums are added in chunk order so results don't depend on scheduling
+    static const size_t solverGrain = 2048;
+
+    uint32_t DisplacementSystem::addRow(Vec3 normal, Vec3 rhsValue) {
+        this->normals.push_back(normal);
+        this->rhs.push_back(rhsValue);
+        this->rowOffsets.push_back(this->rowOffsets.back());
+        return this->normals.size() - 1;
+    }
+
+    static wb_float sumChunks(const std::vector<wb_float>& partials) {
+        wb_float total = 0;
+        for (wb_float partial : partials) {
+            total += partial;
+        }
+        return total;
+    }
+
+    void DisplacementSystem::multiply(ThreadPool& pool, const std::vector<Vec3>& x, std::vector<Vec3>& out) const {
+        pool.parallelFor(this->normals.size(), solverGrain, [&](size_t begin, size_t end) {
+            for (size_t row = begin; row < end; row++) {
+                Vec3 neighborSum;
+                for (uint32_t entry = this->rowOffsets[row]; entry < this->rowOffsets[row + 1]; entry++) {
+                    neighborSum = neighborSum + x[this->columns[entry]] * this->weights[entry];
+                }
+                const Vec3& normal = this->normals[row];
+                out[row] = x[row] - (neighborSum - normal * normal.dot(neighborSum));
+            }
+        });
+    }
+
+    DisplacementSolveResult DisplacementSystem::solve(ThreadPool& pool, wb_float tolerance, uint32_t maxIterations, wb_float reduction) {
+        DisplacementSolveResult result;
+        size_t count = this->normals.size();
+        result.unknowns = count;
+        if (this->solution.size() != count) {
+            this->solution.assign(count, Vec3());
+        }
+        if (count == 0) {
+            return result;
+        }
+        this->residual.resize(count);
+        this->direction.assign(count, Vec3());
+        this->directionProduct.assign(count, Vec3());
+        this->step.resize(count);
+        this->stepProduct.resize(count);
+        std::vector<wb_float> partials((count + solverGrain - 1) / solverGrain);
+        std::vector<wb_float> otherPartials(partials.size());
+
+        // a.b over every component of every row
+        auto dot = [&](const std::vector<Vec3>& a, const std::vector<Vec3>& b) -> wb_float {
+            pool.parallelFor(count, solverGrain, [&](size_t begin, size_t end) {
+                wb_float sum = 0;
+                for (size_t row = begin; row < end; row++) {
+                    sum += a[row].dot(b[row]);
+                }
+                partials[begin / solverGrain] = sum;
+            });
+            return sumChunks(partials);
+        };
+
+        // r = b - A x, the shadow residual stays at the first one
+        this->multiply(pool, this->solution, this->residual);
+        pool.parallelFor(count, solverGrain, [&](size_t begin, size_t end) {
+            wb_float largest = 0;
+            for (size_t row = begin; row < end; row++) {
+                this->residual[row] = this->rhs[row] - this->residual[row];
+                largest = std::max(largest, this->residual[row].length());
+            }
+            otherPartials[begin / solverGrain] = largest;
+        });
+        result.initialLargestRow = *std::max_element(otherPartials.begin(), otherPartials.end());
+        this->shadow = this->residual;
+        wb_float rhsNorm = std::sqrt(dot(this->rhs, this->rhs));
+        if (rhsNorm == 0) {
+            std::fill(this->solution.begin(), this->solution.end(), Vec3());
+            result.initialLargestRow = 0;
+            return result;
+        }
+        result.residual = std::sqrt(dot(this->residual, this->residual)) / rhsNorm;
+        result.initialResidual = result.residual;
+        tolerance = std::max(tolerance, reduction * result.initialResidual);
+
+        wb_float rho = 1, alpha = 1, omega = 1;
+        while (result.iterations < maxIterations && result.residual > tolerance) {
+            wb_float rhoNext = dot(this->shadow, this->residual);
+            if (rhoNext == 0 || omega == 0) {
+                // breakdown, the residual so far is the best we have
+                break;
+            }
+            wb_float beta = (rhoNext / rho) * (alpha / omega);
+            rho = rhoNext;
+            pool.parallelFor(count, solverGrain, [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; row++) {
+                    this->direction[row] = this->residual[row] + (this->direction[row] - this->directionProduct[row] * omega) * beta;
+                }
+            });
+            this->multiply(pool, this->direction, this->directionProduct);
+            wb_float shadowProduct = dot(this->shadow, this->directionProduct);
+            if (shadowProduct == 0) {
+                break;
+            }
+            alpha = rho / shadowProduct;
+
+            // half step, s = r - alpha v
+            pool.parallelFor(count, solverGrain, [&](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; row++) {
+                    this->step[row] = this->residual[row] - this->directionProduct[row] * alpha;
+                }
+            });
+            this->multiply(pool, this->step, this->stepProduct);
+            pool.parallelFor(count, solverGrain, [&](size_t begin, size_t end) {
+                wb_float ts = 0;
+                wb_float tt = 0;
+                for (size_t row = begin; row < end; row++) {
+                    ts += this->stepProduct[row].dot(this->step[row]);
+                    tt += this->stepProduct[row].dot(this->stepProduct[row]);
+                }
+                partials[begin / solverGrain] = ts;
+                otherPartials[begin / solverGrain] = tt;
+            });
+            wb_float stepProductNorm = sumChunks(otherPartials);
+            omega = stepProductNorm > 0 ? sumChunks(partials) / stepProductNorm : 0;
+
+            // x += alpha p + omega s, r = s - omega t
+            pool.parallelFor(count, solverGrain, [&](size_t begin, size_t end) {
+                wb_float rr = 0;
+                for (size_t row = begin; row < end; row++) {
+                    this->solution[row] = this->solution[row] + this->direction[row] * alpha + this->step[row] * omega;
+                    this->residual[row] = this->step[row] - this->stepProduct[row] * omega;
+                    rr += this->residual[row].dot(this->residual[row]);
+                }
+                partials[begin / solverGrain] = rr;
+            });
+            result.iterations++;
+            result.residual = std::sqrt(sumChunks(partials)) / rhsNorm;
+        }
+        return result;
+    }
+}
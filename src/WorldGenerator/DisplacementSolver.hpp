@@ -0,0 +1,94 @@
+// --
+//  DisplacementSolver.hpp
+//  WorldGenerator
+//
+//  Sparse solve for the displacement of a plate's interior cells, the alternative to relaxing it sweep by sweep
+//
+//  The relaxation moves each interior cell to decay times the tangent part of a weighted sum of its neighbors,
+//  a neighbor's weight depending only on which way its displacement points (see World::desiredDisplacement):
+//      d_i = decay * P_i * sum(w_ij(d_j) * d_j)
+//  With the weights frozen at some guess that is linear, and pushed edge cells move to the right hand side:
+//      d_i - decay * P_i * sum(w_ij * interior d_j) = decay * P_i * sum(w_ij * pushed d_j)
+//  The weights aren't symmetric, so the system is solved with BiCGSTAB. World::solvePlateDisplacement re-freezes
+//  the weights at each solution until the relaxation's own update leaves the field where it is
+
+
+#ifndef DisplacementSolver_hpp
+#define DisplacementSolver_hpp
+
+#include <vector>
+
+#include "Defines.h"
+#include "math.hpp"
+#include "ThreadPool.hpp"
+
+namespace WorldBuilder {
+    // how the last solve went, residuals are ||b - Ax|| / ||b||
+    struct DisplacementSolveResult {
+        uint32_t unknowns;
+        uint32_t iterations;
+        uint32_t reweights; // times the weights were frozen again, filled in by the caller
+        wb_float initialResidual; // of the starting guess
+        wb_float initialLargestRow; // length of the starting guess's largest row of b - Ax
+        wb_float residual;
+
+        DisplacementSolveResult() : unknowns(0), iterations(0), reweights(0), initialResidual(0), initialLargestRow(0), residual(0){};
+    };
+
+    /***************  Displacement System ***************/
+    /*  Rows added in unknown order, each row's couplings refer to other rows by index
+     *  Row i reads (A x)_i = x_i - P_i * sum(weight * x_column), P_i removing the component along the row's normal
+     *  The three components are solved together as one system, the projection mixes them
+     */
+    class DisplacementSystem {
+    private:
+        std::vector<uint32_t> rowOffsets; // row r couples to columns[rowOffsets[r]] up to columns[rowOffsets[r + 1]]
+        std::vector<uint32_t> columns;
+        std::vector<wb_float> weights;
+        std::vector<Vec3> normals;
+        std::vector<Vec3> rhs;
+
+        // BiCGSTAB work vectors, kept so repeat solves don't reallocate
+        std::vector<Vec3> residual;
+        std::vector<Vec3> shadow;
+        std::vector<Vec3> direction;
+        std::vector<Vec3> directionProduct;
+        std::vector<Vec3> step;
+        std::vector<Vec3> stepProduct;
+
+        void multiply(ThreadPool& pool, const std::vector<Vec3>& x, std::vector<Vec3>& out) const;
+
+    public:
+        // starting guess going in, the answer coming out
+        std::vector<Vec3> solution;
+
+        DisplacementSystem() : rowOffsets(1, 0){};
+
+        // returns the row index
+        uint32_t addRow(Vec3 normal, Vec3 rhsValue);
+        // couples the last added row to column, couplings are numbered in the order added
+        void addCoupling(uint32_t column, wb_float weight) {
+            columns.push_back(column);
+            weights.push_back(weight);
+            rowOffsets.back()++;
+        }
+        
+        // once the couplings are in place, new weights only change values, safe to call for different rows in parallel
+        void set_rhs(uint32_t row, Vec3 value) {
+            rhs[row] = value;
+        }
+        void set_weight(uint32_t coupling, wb_float weight) {
+            weights[coupling] = weight;
+        }
+
+        uint32_t size() const {
+            return normals.size();
+        }
+
+        // starts from solution, zeroed if it doesn't have a value per row, stops once the relative residual is under
+        // tolerance or has come down to reduction times where it started
+        DisplacementSolveResult solve(ThreadPool& pool, wb_float tolerance, uint32_t maxIterations, wb_float reduction = 0);
+    }; // class DisplacementSystem
+} // namespace WorldBuilder
+
+#endif /* DisplacementSolver_hpp */
@@ -48,7 +48,7 @@ namespace WorldBuilder {
      *
      */
     class MaterialFlowNode {
-        std::shared_ptr<PlateCell> source;
+        PlateCell* source; // owned by a plate, valid while the plates' cells are not added or removed
         MaterialFlowBasin* basin;
     public:
         wb_float downhillSlope;
@@ -66,7 +66,7 @@ namespace WorldBuilder {
         uint32_t plateIndex;
         uint32_t cellIndex;
 
-        void set_source(std::shared_ptr<PlateCell> s) {
+        void set_source(PlateCell* s) {
             this->source = s;
         }
         
@@ -5,87 +5,870 @@
 
 
 #include "Grid.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <memory>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace WorldBuilder {
-    Grid::Grid(const api::Grid *theGrid) : verts(theGrid->vertices_size()){
-        // copy our verts over
+    // runs work(begin, end) over contiguous slices of [0, count), one per thread of the shared pool
+    template <typename Function>
+    static void splitAmongThreads(uint32_t count, Function work) {
+        std::shared_ptr<ThreadPool> pool = ThreadPool::shared();
+        pool->parallelFor(count, pool->evenGrain(count), [&work](size_t begin, size_t end) {
+            work(begin, end);
+        });
+    }
+
+    Grid::Grid() : vertexCount(0), positionData(nullptr), neighborCenterData(nullptr), neighborOffsetData(nullptr), neighborIndexData(nullptr), edgeDirectionData(nullptr), edgeLengthData(nullptr), cellRadiusData(nullptr), spatialSeedData(nullptr), originalIndexData(nullptr), vertexForOriginalData(nullptr), spatialResolution(0), mappedAddress(nullptr), mappedLength(0) {
+    }
+
+    Grid::Grid(const api::Grid *theGrid) : vertexCount(theGrid->vertices_size()), positionData(nullptr), neighborCenterData(nullptr), neighborOffsetData(nullptr), neighborIndexData(nullptr), edgeDirectionData(nullptr), edgeLengthData(nullptr), cellRadiusData(nullptr), spatialSeedData(nullptr), originalIndexData(nullptr), vertexForOriginalData(nullptr), positions(theGrid->vertices_size()), neighborCenters(theGrid->vertices_size()), neighborOffsets(theGrid->vertices_size() + 1), spatialResolution(0), mappedAddress(nullptr), mappedLength(0) {
+        // count neighbors first so the CSR block is allocated once
         uint_fast32_t count = theGrid->vertices_size();
+        uint32_t totalNeighbors = 0;
         for (uint_fast32_t index = 0; index < count; index++) {
-            api::GridVertex apiVertex = theGrid->vertices(index);
-            verts[index].index = index;
-            verts[index].vector.coords[0] = apiVertex.xcoord();
-            verts[index].vector.coords[1] = apiVertex.ycoord();
-            verts[index].vector.coords[2] = apiVertex.zcoord();
+            neighborOffsets[index] = totalNeighbors;
+            totalNeighbors += theGrid->vertices(index).neighbors_size();
+        }
+        neighborOffsets[count] = totalNeighbors;
+        neighborIndices.resize(totalNeighbors);
+
+        // copy our verts over
+        for (uint_fast32_t index = 0; index < count; index++) {
+            const api::GridVertex& apiVertex = theGrid->vertices(index);
+            positions[index].coords[0] = apiVertex.xcoord();
+            positions[index].coords[1] = apiVertex.ycoord();
+            positions[index].coords[2] = apiVertex.zcoord();
             // set neighbors
+            uint32_t* neighbors = &neighborIndices[neighborOffsets[index]];
             uint_fast32_t neighborCount = apiVertex.neighbors_size();
-            std::vector<GridVertex *> temp(neighborCount);
-            verts[index].neighbors = temp;
             for (uint_fast32_t neighborIndex = 0; neighborIndex < neighborCount; neighborIndex++) {
-                verts[index].neighbors[neighborIndex] = &verts[apiVertex.neighbors(neighborIndex)];
+                neighbors[neighborIndex] = apiVertex.neighbors(neighborIndex);
             }
         }
+        this->createHandles();
+        this->bindStorage();
+    }
+
+    Grid::Grid(uint32_t vertexCount) : vertexCount(vertexCount), positionData(nullptr), neighborCenterData(nullptr), neighborOffsetData(nullptr), neighborIndexData(nullptr), edgeDirectionData(nullptr), edgeLengthData(nullptr), cellRadiusData(nullptr), spatialSeedData(nullptr), originalIndexData(nullptr), vertexForOriginalData(nullptr), positions(vertexCount), neighborCenters(vertexCount), neighborOffsets(vertexCount + 1), spatialResolution(0), mappedAddress(nullptr), mappedLength(0) {
+        this->createHandles();
+        this->bindStorage();
     }
-    
-    Grid::Grid(uint32_t vertexCount) : verts(vertexCount) {
-        
+
+    Grid::~Grid() {
+        if (mappedAddress != nullptr) {
+            munmap(mappedAddress, mappedLength);
+        }
     }
-    
+
+    void Grid::bindStorage() {
+        positionData = positions.data();
+        neighborCenterData = neighborCenters.data();
+        neighborOffsetData = neighborOffsets.data();
+        neighborIndexData = neighborIndices.data();
+        edgeDirectionData = edgeDirections.data();
+        edgeLengthData = edgeLengths.data();
+        cellRadiusData = cellRadii.data();
+        spatialSeedData = spatialSeeds.data();
+        originalIndexData = originalIndices.size() > 0 ? originalIndices.data() : nullptr;
+        vertexForOriginalData = vertexForOriginal.size() > 0 ? vertexForOriginal.data() : nullptr;
+    }
+
+/*************** Icosphere Generation ***************/
+    // base faces are wound counter clockwise when viewed from outside
+    static const uint32_t icosahedronFaces[20][3] = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+    };
+
+    Grid* Grid::icosphere(uint32_t subdivisionLevel) {
+        if (subdivisionLevel > 13) {
+            // 10 * 4^14 + 2 vertices overflows the 32 bit neighbor offsets
+            throw std::invalid_argument("Icosphere subdivision level too large");
+        }
+        const uint32_t segments = 1 << subdivisionLevel;
+        const uint32_t edgeInterior = segments - 1;
+        const uint32_t faceInterior = segments < 2 ? 0 : (segments - 1) * (segments - 2) / 2;
+        const uint32_t edgeBase = 12;
+        const uint32_t faceBase = edgeBase + 30 * edgeInterior;
+        const uint32_t vertexCount = faceBase + 20 * faceInterior;
+        const uint32_t trianglesPerFace = segments * segments;
+        const uint32_t triangleCount = 20 * trianglesPerFace;
+
+        Grid* grid = new Grid(vertexCount);
+
+        // corners
+        wb_float golden = (1.0 + std::sqrt(5.0)) / 2.0;
+        const wb_float cornerCoords[12][3] = {
+            {-1, golden, 0}, {1, golden, 0}, {-1, -golden, 0}, {1, -golden, 0},
+            {0, -1, golden}, {0, 1, golden}, {0, -1, -golden}, {0, 1, -golden},
+            {golden, 0, -1}, {golden, 0, 1}, {-golden, 0, -1}, {-golden, 0, 1}
+        };
+        Vec3 corners[12];
+        for (uint32_t corner = 0; corner < 12; corner++) {
+            Vec3 position;
+            position.coords[0] = cornerCoords[corner][0];
+            position.coords[1] = cornerCoords[corner][1];
+            position.coords[2] = cornerCoords[corner][2];
+            corners[corner] = math::normalize3Vector(position);
+            grid->positions[corner] = corners[corner];
+        }
+
+        // edges numbered in order of first appearance in the face table
+        uint32_t edgeIds[12][12];
+        uint32_t edgeEnds[30][2];
+        uint32_t edgeCount = 0;
+        for (uint32_t face = 0; face < 20; face++) {
+            for (uint32_t side = 0; side < 3; side++) {
+                uint32_t a = icosahedronFaces[face][side];
+                uint32_t b = icosahedronFaces[face][(side + 1) % 3];
+                if (a < b) {
+                    edgeIds[a][b] = edgeIds[b][a] = edgeCount;
+                    edgeEnds[edgeCount][0] = a;
+                    edgeEnds[edgeCount][1] = b;
+                    edgeCount++;
+                }
+            }
+        }
+
+        // edge interiors run from the lower numbered corner to the higher
+        for (uint32_t edge = 0; edge < 30; edge++) {
+            const Vec3& start = corners[edgeEnds[edge][0]];
+            Vec3 step = (corners[edgeEnds[edge][1]] - start) * (1.0 / segments);
+            for (uint32_t k = 1; k < segments; k++) {
+                grid->positions[edgeBase + edge * edgeInterior + k - 1] = math::normalize3Vector(start + step * (wb_float)k);
+            }
+        }
+
+        // lattice point (i, j) of a face is A + (B - A) * i / segments + (C - A) * j / segments
+        auto vertexAt = [&](uint32_t face, uint32_t i, uint32_t j) -> uint32_t {
+            uint32_t a = icosahedronFaces[face][0];
+            uint32_t b = icosahedronFaces[face][1];
+            uint32_t c = icosahedronFaces[face][2];
+            uint32_t from, to, k;
+            if (j == 0) {
+                if (i == 0) return a;
+                if (i == segments) return b;
+                from = a; to = b; k = i;
+            } else if (i == 0) {
+                if (j == segments) return c;
+                from = a; to = c; k = j;
+            } else if (i + j == segments) {
+                from = b; to = c; k = j;
+            } else {
+                // face interior rows by j, row j holds i in [1, segments - 1 - j]
+                uint32_t row = j - 1;
+                uint32_t rowStart = row * (segments - 1) - row * (row + 1) / 2;
+                return faceBase + face * faceInterior + rowStart + i - 1;
+            }
+            uint32_t edgeStart = edgeBase + edgeIds[from][to] * edgeInterior;
+            return from < to ? edgeStart + k - 1 : edgeStart + segments - k - 1;
+        };
+
+        // face interior positions and triangles, each face is independent
+        std::vector<uint32_t> triangles(3 * (size_t)triangleCount);
+        splitAmongThreads(20, [&](uint32_t faceBegin, uint32_t faceEnd) {
+            for (uint32_t face = faceBegin; face < faceEnd; face++) {
+                const Vec3& a = corners[icosahedronFaces[face][0]];
+                Vec3 stepI = (corners[icosahedronFaces[face][1]] - a) * (1.0 / segments);
+                Vec3 stepJ = (corners[icosahedronFaces[face][2]] - a) * (1.0 / segments);
+                for (uint32_t j = 1; j + 1 < segments; j++) {
+                    for (uint32_t i = 1; i + j < segments; i++) {
+                        grid->positions[vertexAt(face, i, j)] = math::normalize3Vector(a + stepI * (wb_float)i + stepJ * (wb_float)j);
+                    }
+                }
+
+                uint32_t* triangle = &triangles[3 * (size_t)face * trianglesPerFace];
+                for (uint32_t j = 0; j < segments; j++) {
+                    for (uint32_t i = 0; i + j < segments; i++) {
+                        triangle[0] = vertexAt(face, i, j);
+                        triangle[1] = vertexAt(face, i + 1, j);
+                        triangle[2] = vertexAt(face, i, j + 1);
+                        triangle += 3;
+                        if (i + j + 2 <= segments) {
+                            triangle[0] = vertexAt(face, i + 1, j);
+                            triangle[1] = vertexAt(face, i + 1, j + 1);
+                            triangle[2] = vertexAt(face, i, j + 1);
+                            triangle += 3;
+                        }
+                    }
+                }
+            }
+        });
+
+        // on a closed triangulated surface each vertex has as many neighbors as incident triangles
+        std::vector<uint32_t>& offsets = grid->neighborOffsets;
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint32_t corner : triangles) {
+            offsets[corner + 1]++;
+        }
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            offsets[index + 1] += offsets[index];
+        }
+        std::vector<uint32_t> incident(offsets[vertexCount]);
+        std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                incident[filled[triangles[3 * (size_t)triangle + corner]]++] = triangle;
+            }
+        }
+        std::vector<uint32_t>().swap(filled);
+
+        // chain the triangles around each vertex into a counter clockwise ring
+        grid->neighborIndices.resize(offsets[vertexCount]);
+        splitAmongThreads(vertexCount, [&](uint32_t vertexBegin, uint32_t vertexEnd) {
+            uint32_t previous[6];
+            uint32_t next[6];
+            for (uint32_t vertex = vertexBegin; vertex < vertexEnd; vertex++) {
+                uint32_t count = offsets[vertex + 1] - offsets[vertex];
+                for (uint32_t k = 0; k < count; k++) {
+                    const uint32_t* triangle = &triangles[3 * (size_t)incident[offsets[vertex] + k]];
+                    uint32_t corner = triangle[0] == vertex ? 0 : (triangle[1] == vertex ? 1 : 2);
+                    previous[k] = triangle[(corner + 1) % 3];
+                    next[k] = triangle[(corner + 2) % 3];
+                }
+                uint32_t* ring = &grid->neighborIndices[offsets[vertex]];
+                ring[0] = previous[0];
+                for (uint32_t k = 1; k < count; k++) {
+                    uint32_t link = 0;
+                    while (previous[link] != ring[k - 1]) {
+                        link++;
+                    }
+                    ring[k] = next[link];
+                }
+            }
+        });
+
+        grid->finishLoading();
+        return grid;
+    }
+
     void Grid::addGrpcGridPart(const api::Grid *theGrid){
-        // copy our verts over
+        if (this->isMapped()) {
+            throw std::logic_error("Cannot add parts to a mapped grid");
+        }
+        if (stagedNeighborCounts.size() == 0) {
+            stagedNeighborCounts.resize(this->verts_size());
+            stagedNeighborStarts.resize(this->verts_size());
+        }
+        // copy our verts over, neighbors are staged until all parts have arrived
         uint_fast32_t count = theGrid->vertices_size();
         for (uint_fast32_t index = 0; index < count; index++) {
-            api::GridVertex apiVertex = theGrid->vertices(index);
-            verts[apiVertex.index()].index = apiVertex.index();
-            verts[apiVertex.index()].vector.coords[0] = apiVertex.xcoord();
-            verts[apiVertex.index()].vector.coords[1] = apiVertex.ycoord();
-            verts[apiVertex.index()].vector.coords[2] = apiVertex.zcoord();
-            // set neighbors
+            const api::GridVertex& apiVertex = theGrid->vertices(index);
+            uint32_t vertexIndex = apiVertex.index();
+            positions[vertexIndex].coords[0] = apiVertex.xcoord();
+            positions[vertexIndex].coords[1] = apiVertex.ycoord();
+            positions[vertexIndex].coords[2] = apiVertex.zcoord();
+            // stage neighbors
             uint_fast32_t neighborCount = apiVertex.neighbors_size();
-            std::vector<GridVertex *> temp(neighborCount);
-            verts[apiVertex.index()].neighbors = temp;
+            stagedNeighborStarts[vertexIndex] = stagedNeighbors.size();
+            stagedNeighborCounts[vertexIndex] = neighborCount;
             for (uint_fast32_t neighborIndex = 0; neighborIndex < neighborCount; neighborIndex++) {
-                verts[apiVertex.index()].neighbors[neighborIndex] = &verts[apiVertex.neighbors(neighborIndex)];
+                stagedNeighbors.push_back(apiVertex.neighbors(neighborIndex));
             }
         }
     }
-    
+
+    void Grid::compactStagedNeighbors() {
+        uint32_t vertexCount = this->verts_size();
+        uint32_t totalNeighbors = 0;
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            neighborOffsets[index] = totalNeighbors;
+            totalNeighbors += stagedNeighborCounts[index];
+        }
+        neighborOffsets[vertexCount] = totalNeighbors;
+
+        neighborIndices.resize(totalNeighbors);
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            std::copy(stagedNeighbors.begin() + stagedNeighborStarts[index],
+                      stagedNeighbors.begin() + stagedNeighborStarts[index] + stagedNeighborCounts[index],
+                      neighborIndices.begin() + neighborOffsets[index]);
+        }
+
+        // release staging
+        std::vector<uint32_t>().swap(stagedNeighbors);
+        std::vector<uint32_t>().swap(stagedNeighborStarts);
+        std::vector<uint32_t>().swap(stagedNeighborCounts);
+    }
+
+    void Grid::finishLoading() {
+        if (this->isMapped()) {
+            // everything was built before the file was written
+            return;
+        }
+        if (stagedNeighborCounts.size() > 0) {
+            this->compactStagedNeighbors();
+        }
+        this->bindStorage();
+        this->buildCenters();
+        this->buildEdgeGeometry();
+        this->buildSpatialIndex();
+        this->bindStorage();
+    }
+
     void Grid::buildCenters() {
-        for (auto vertexIt = this->verts.begin(); vertexIt != this->verts.end(); vertexIt++) {
+        if (this->isMapped()) {
+            return;
+        }
+        uint32_t vertexCount = this->verts_size();
+        for (uint32_t index = 0; index < vertexCount; index++) {
             Vec3 center;
-            for (auto neighborIt = vertexIt->neighbors.begin(); neighborIt != vertexIt->neighbors.end(); neighborIt++) {
-                center = center + (*neighborIt)->get_vector();
+            for (uint32_t neighborIndex : this->get_neighbors(index)) {
+                center = center + positionData[neighborIndex];
             }
             center = math::normalize3Vector(center);
-            vertexIt->neighborCenter = center;
-        }
-    }
-
-    std::unordered_map<uint32_t, GridVertex *> GridVertex::neighborsByDepth(uint32_t dist) const {
-        // create 
-        auto newNeighbors = std::make_shared<std::unordered_map<uint32_t, GridVertex*>>();
-        std::unordered_map<uint32_t, GridVertex*> depthNeighbors;
-        //neighbors.reserve(/*some count*/);
-        for (auto neigh : this->neighbors) {
-            depthNeighbors.insert({neigh->index, neigh});
-            newNeighbors->insert({neigh->index, neigh});
-        }
-
-        for (uint32_t depth = 1; depth < dist; depth++) {
-            auto currentTest = newNeighbors;
-            newNeighbors = std::make_unique<std::unordered_map<uint32_t, GridVertex*>>();
-            for (auto neighTestIt : *currentTest) {
-                auto neighTest = neighTestIt.second;
-                for (auto neigh : neighTest->neighbors) {
-                    // check if in neighbors
-                    if (depthNeighbors.find(neigh->index) == depthNeighbors.end()) {
-                        depthNeighbors.insert({neigh->index, neigh});
-                        newNeighbors->insert({neigh->index, neigh});
+            neighborCenters[index] = center;
+        }
+    }
+
+    void Grid::buildEdgeGeometry() {
+        uint32_t vertexCount = this->verts_size();
+        edgeDirections.resize(neighborIndices.size());
+        edgeLengths.resize(neighborIndices.size());
+        cellRadii.resize(vertexCount);
+        splitAmongThreads(vertexCount, [this](uint32_t vertexBegin, uint32_t vertexEnd) {
+            for (uint32_t index = vertexBegin; index < vertexEnd; index++) {
+                const Vec3& position = positions[index];
+                for (uint32_t offset = neighborOffsets[index]; offset < neighborOffsets[index + 1]; offset++) {
+                    const Vec3& neighborPosition = positions[neighborIndices[offset]];
+                    edgeDirections[offset] = math::normalize3Vector(position - neighborPosition);
+                    edgeLengths[offset] = math::distanceBetween3Points(position, neighborPosition);
+                }
+                cellRadii[index] = neighborOffsets[index + 1] > neighborOffsets[index] ? edgeLengths[neighborOffsets[index]] / 2 : 0;
+            }
+        });
+    }
+
+/*************** Spatial Index ***************/
+    // projects onto the unit cube, face is the dominant axis and its sign
+    // u and v are in [-major, major]
+    uint32_t Grid::cubeFace(const Vec3& location, wb_float& u, wb_float& v, wb_float& major) {
+        wb_float absX = std::abs(location[0]);
+        wb_float absY = std::abs(location[1]);
+        wb_float absZ = std::abs(location[2]);
+        uint32_t face;
+        if (absX >= absY && absX >= absZ) {
+            face = location[0] >= 0 ? 0 : 1;
+            major = absX;
+            u = location[1];
+            v = location[2];
+        } else if (absY >= absZ) {
+            face = location[1] >= 0 ? 2 : 3;
+            major = absY;
+            u = location[2];
+            v = location[0];
+        } else {
+            face = location[2] >= 0 ? 4 : 5;
+            major = absZ;
+            u = location[0];
+            v = location[1];
+        }
+        return face;
+    }
+
+    uint32_t Grid::spatialBucket(const Vec3& location) const {
+        wb_float u, v, major;
+        uint32_t face = cubeFace(location, u, v, major);
+        if (!(major > 0)) {
+            // degenerate or nan location, any bucket will do
+            return 0;
+        }
+        // face coords in [0, resolution)
+        wb_float scale = 0.5 * spatialResolution / major;
+        wb_float fu = (u + major) * scale;
+        wb_float fv = (v + major) * scale;
+        uint32_t column = fu <= 0 ? 0 : std::min(spatialResolution - 1, (uint32_t)fu);
+        uint32_t row = fv <= 0 ? 0 : std::min(spatialResolution - 1, (uint32_t)fv);
+        return (face * spatialResolution + row) * spatialResolution + column;
+    }
+
+    Vec3 Grid::spatialBucketCenter(uint32_t bucket) const {
+        uint32_t column = bucket % spatialResolution;
+        uint32_t row = (bucket / spatialResolution) % spatialResolution;
+        uint32_t face = bucket / (spatialResolution * spatialResolution);
+        wb_float u = (2.0 * (column + 0.5) / spatialResolution) - 1.0;
+        wb_float v = (2.0 * (row + 0.5) / spatialResolution) - 1.0;
+        wb_float major = (face % 2 == 0) ? 1.0 : -1.0;
+        Vec3 center;
+        switch (face / 2) {
+            case 0:
+                center.coords[0] = major;
+                center.coords[1] = u;
+                center.coords[2] = v;
+                break;
+            case 1:
+                center.coords[1] = major;
+                center.coords[2] = u;
+                center.coords[0] = v;
+                break;
+            default:
+                center.coords[2] = major;
+                center.coords[0] = u;
+                center.coords[1] = v;
+                break;
+        }
+        return math::normalize3Vector(center);
+    }
+
+    void Grid::buildSpatialIndex() {
+        uint32_t vertexCount = this->verts_size();
+        if (vertexCount == 0) {
+            spatialResolution = 0;
+            spatialSeeds.clear();
+            return;
+        }
+        // roughly one bucket per vertex
+        spatialResolution = std::max<uint32_t>(1, (uint32_t)std::ceil(std::sqrt(vertexCount / 6.0)));
+        spatialSeeds.resize(6 * spatialResolution * spatialResolution);
+
+        // seed each bucket from its scan order neighbor so the walks stay short
+        uint32_t rowStartSeed = 0;
+        for (uint32_t face = 0; face < 6; face++) {
+            for (uint32_t row = 0; row < spatialResolution; row++) {
+                uint32_t seed = rowStartSeed;
+                for (uint32_t column = 0; column < spatialResolution; column++) {
+                    uint32_t bucket = (face * spatialResolution + row) * spatialResolution + column;
+                    this->descendToNearest(this->spatialBucketCenter(bucket), seed, std::numeric_limits<uint32_t>::max(), seed);
+                    spatialSeeds[bucket] = seed;
+                    if (column == 0) {
+                        rowStartSeed = seed;
                     }
                 }
             }
         }
+    }
+
+    bool Grid::descendToNearest(const Vec3& location, uint32_t start, uint32_t maxSteps, uint32_t& nearest) const {
+        const uint32_t* offsets = neighborOffsetData;
+        const uint32_t* indices = neighborIndexData;
+        uint32_t currentNearest = start;
+        wb_float smallestSquareDistance = math::squareDistanceBetween3Points(location, positionData[currentNearest]);
+        for (uint32_t step = 0; ; step++) {
+            uint32_t testSetNearest = currentNearest;
+            for (uint32_t offset = offsets[currentNearest]; offset < offsets[currentNearest + 1]; offset++) {
+                uint32_t vertex = indices[offset];
+                wb_float testDistance = math::squareDistanceBetween3Points(location, positionData[vertex]);
+                if (testDistance < smallestSquareDistance) {
+                    smallestSquareDistance = testDistance;
+                    testSetNearest = vertex;
+                }
+            }
+            if (testSetNearest == currentNearest) {
+                nearest = currentNearest;
+                return true;
+            }
+            // a closer neighbor is left but the moves are used up
+            if (step == maxSteps) {
+                nearest = currentNearest;
+                return false;
+            }
+            currentNearest = testSetNearest;
+        }
+    }
+
+    uint32_t Grid::nearestIndex(const Vec3& location) const {
+        uint32_t nearest = spatialSeedData[this->spatialBucket(location)];
+        this->descendToNearest(location, nearest, std::numeric_limits<uint32_t>::max(), nearest);
+        return nearest;
+    }
+
+    void Grid::nearestIndices(const Vec3* locations, uint32_t count, uint32_t* nearest) const {
+        uint32_t index = 0;
+#ifdef __AVX2__
+        // spatialBucket four locations at a time, same operations in the same order so the buckets match exactly
+        static_assert(sizeof(Vec3) == 3 * sizeof(double), "AVX2 bucket kernel assumes packed double Vec3");
+        if (spatialResolution > 0) {
+            const __m256d signBit = _mm256_set1_pd(-0.0);
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d halfResolution = _mm256_set1_pd(0.5 * spatialResolution);
+            const __m256d lastCell = _mm256_set1_pd(spatialResolution - 1);
+            const __m256d resolution = _mm256_set1_pd(spatialResolution);
+            const __m128i coordStride = _mm_setr_epi32(0, 3, 6, 9);
+            for (; index + 4 <= count; index += 4) {
+                const double* base = locations[index].coords;
+                __m256d x = _mm256_i32gather_pd(base, coordStride, 8);
+                __m256d y = _mm256_i32gather_pd(base + 1, coordStride, 8);
+                __m256d z = _mm256_i32gather_pd(base + 2, coordStride, 8);
+                __m256d absX = _mm256_andnot_pd(signBit, x);
+                __m256d absY = _mm256_andnot_pd(signBit, y);
+                __m256d absZ = _mm256_andnot_pd(signBit, z);
+                // cubeFace, x wins ties over y and z, y wins ties over z
+                __m256d xMajor = _mm256_and_pd(_mm256_cmp_pd(absX, absY, _CMP_GE_OQ), _mm256_cmp_pd(absX, absZ, _CMP_GE_OQ));
+                __m256d yMajor = _mm256_andnot_pd(xMajor, _mm256_cmp_pd(absY, absZ, _CMP_GE_OQ));
+                __m256d major = _mm256_blendv_pd(_mm256_blendv_pd(absZ, absY, yMajor), absX, xMajor);
+                __m256d majorCoord = _mm256_blendv_pd(_mm256_blendv_pd(z, y, yMajor), x, xMajor);
+                __m256d u = _mm256_blendv_pd(_mm256_blendv_pd(x, z, yMajor), y, xMajor);
+                __m256d v = _mm256_blendv_pd(_mm256_blendv_pd(y, x, yMajor), z, xMajor);
+                __m256d face = _mm256_blendv_pd(_mm256_blendv_pd(_mm256_set1_pd(4), _mm256_set1_pd(2), yMajor), zero, xMajor);
+                face = _mm256_add_pd(face, _mm256_and_pd(one, _mm256_cmp_pd(majorCoord, zero, _CMP_NGE_UQ)));
+                // face coords in [0, resolution), max before min sends nan to column 0
+                __m256d scale = _mm256_div_pd(halfResolution, major);
+                __m256d column = _mm256_floor_pd(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_add_pd(u, major), scale), zero), lastCell));
+                __m256d row = _mm256_floor_pd(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_add_pd(v, major), scale), zero), lastCell));
+                __m256d bucket = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(face, resolution), row), resolution), column);
+                // degenerate or nan location, any bucket will do
+                bucket = _mm256_and_pd(bucket, _mm256_cmp_pd(major, zero, _CMP_GT_OQ));
+                __m128i buckets = _mm256_cvttpd_epi32(bucket);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(nearest + index), _mm_i32gather_epi32(reinterpret_cast<const int*>(spatialSeedData), buckets, 4));
+            }
+        }
+#endif
+        for (; index < count; index++) {
+            nearest[index] = spatialSeedData[this->spatialBucket(locations[index])];
+        }
+        for (index = 0; index < count; index++) {
+            this->descendToNearest(locations[index], nearest[index], std::numeric_limits<uint32_t>::max(), nearest[index]);
+        }
+    }
+
+/*************** Cache File ***************/
+    static const char gridFileMagic[8] = {'W', 'B', 'G', 'R', 'I', 'D', 0, 0};
+    static const uint32_t gridFileVersion = 3;
+    static const uint32_t gridFileByteOrder = 0x01020304;
+    static const uint64_t gridFileAlignment = 64;
+
+    struct GridFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t floatSize;
+        uint32_t vertexCount;
+        uint32_t neighborCount;
+        uint32_t spatialResolution;
+        uint32_t reordered; // 1 if the permutation sections are present
+        uint32_t reserved;
+        // byte offsets from the start of the file
+        uint64_t positionsOffset;
+        uint64_t neighborCentersOffset;
+        uint64_t neighborOffsetsOffset;
+        uint64_t neighborIndicesOffset;
+        uint64_t edgeDirectionsOffset;
+        uint64_t edgeLengthsOffset;
+        uint64_t cellRadiiOffset;
+        uint64_t spatialSeedsOffset;
+        uint64_t originalIndicesOffset;
+        uint64_t vertexForOriginalOffset;
+        uint64_t fileSize;
+    };
+
+    static uint64_t alignedFileOffset(uint64_t offset) {
+        return (offset + gridFileAlignment - 1) / gridFileAlignment * gridFileAlignment;
+    }
+
+    // fills in the section offsets for the given counts
+    static GridFileHeader gridFileLayout(uint32_t vertexCount, uint32_t neighborCount, uint32_t spatialResolution, uint32_t reordered) {
+        GridFileHeader header;
+        std::memcpy(header.magic, gridFileMagic, sizeof(gridFileMagic));
+        header.version = gridFileVersion;
+        header.byteOrder = gridFileByteOrder;
+        header.floatSize = sizeof(wb_float);
+        header.vertexCount = vertexCount;
+        header.neighborCount = neighborCount;
+        header.spatialResolution = spatialResolution;
+        header.reordered = reordered;
+        header.reserved = 0;
+        header.positionsOffset = alignedFileOffset(sizeof(GridFileHeader));
+        header.neighborCentersOffset = alignedFileOffset(header.positionsOffset + (uint64_t)vertexCount * sizeof(Vec3));
+        header.neighborOffsetsOffset = alignedFileOffset(header.neighborCentersOffset + (uint64_t)vertexCount * sizeof(Vec3));
+        header.neighborIndicesOffset = alignedFileOffset(header.neighborOffsetsOffset + ((uint64_t)vertexCount + 1) * sizeof(uint32_t));
+        header.edgeDirectionsOffset = alignedFileOffset(header.neighborIndicesOffset + (uint64_t)neighborCount * sizeof(uint32_t));
+        header.edgeLengthsOffset = alignedFileOffset(header.edgeDirectionsOffset + (uint64_t)neighborCount * sizeof(Vec3));
+        header.cellRadiiOffset = alignedFileOffset(header.edgeLengthsOffset + (uint64_t)neighborCount * sizeof(wb_float));
+        header.spatialSeedsOffset = alignedFileOffset(header.cellRadiiOffset + (uint64_t)vertexCount * sizeof(wb_float));
+        uint64_t permutationLength = reordered ? (uint64_t)vertexCount * sizeof(uint32_t) : 0;
+        header.originalIndicesOffset = alignedFileOffset(header.spatialSeedsOffset + 6 * (uint64_t)spatialResolution * spatialResolution * sizeof(uint32_t));
+        header.vertexForOriginalOffset = alignedFileOffset(header.originalIndicesOffset + permutationLength);
+        header.fileSize = header.vertexForOriginalOffset + permutationLength;
+        return header;
+    }
+
+    void Grid::writeFile(const std::string& path) const {
+        uint32_t neighborCount = vertexCount > 0 ? neighborOffsetData[vertexCount] : 0;
+        uint32_t reordered = originalIndexData != nullptr ? 1 : 0;
+        GridFileHeader header = gridFileLayout(vertexCount, neighborCount, spatialResolution, reordered);
+
+        // mkstemp creates a name no other writer, in this process or another, can get, so concurrent writers
+        // of the same cache each fill their own file and the last rename wins
+        std::string temporaryPath = path + ".tmpXXXXXX";
+        int temporaryDescriptor = mkstemp(&temporaryPath[0]);
+        if (temporaryDescriptor < 0) {
+            throw std::runtime_error("Could not create temporary grid file for: " + path);
+        }
+        // mkstemp leaves the file private, the cache is shared like any other file
+        fchmod(temporaryDescriptor, 0644);
+        close(temporaryDescriptor);
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Could not open grid file for writing: " + temporaryPath);
+        }
+        auto writeSection = [&file](uint64_t offset, const void* data, uint64_t length) {
+            // pad up to the section start
+            static const char padding[gridFileAlignment] = {0};
+            uint64_t position = file.tellp();
+            file.write(padding, offset - position);
+            file.write(static_cast<const char*>(data), length);
+        };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeSection(header.positionsOffset, positionData, (uint64_t)vertexCount * sizeof(Vec3));
+        writeSection(header.neighborCentersOffset, neighborCenterData, (uint64_t)vertexCount * sizeof(Vec3));
+        writeSection(header.neighborOffsetsOffset, neighborOffsetData, ((uint64_t)vertexCount + 1) * sizeof(uint32_t));
+        writeSection(header.neighborIndicesOffset, neighborIndexData, (uint64_t)neighborCount * sizeof(uint32_t));
+        writeSection(header.edgeDirectionsOffset, edgeDirectionData, (uint64_t)neighborCount * sizeof(Vec3));
+        writeSection(header.edgeLengthsOffset, edgeLengthData, (uint64_t)neighborCount * sizeof(wb_float));
+        writeSection(header.cellRadiiOffset, cellRadiusData, (uint64_t)vertexCount * sizeof(wb_float));
+        writeSection(header.spatialSeedsOffset, spatialSeedData, 6 * (uint64_t)spatialResolution * spatialResolution * sizeof(uint32_t));
+        if (reordered) {
+            writeSection(header.originalIndicesOffset, originalIndexData, (uint64_t)vertexCount * sizeof(uint32_t));
+            writeSection(header.vertexForOriginalOffset, vertexForOriginalData, (uint64_t)vertexCount * sizeof(uint32_t));
+        }
+        // pad out to the recorded size, the last section may end short of an aligned offset
+        writeSection(header.fileSize, nullptr, 0);
+        file.close();
+        if (!file) {
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Failed writing grid file: " + temporaryPath);
+        }
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            std::remove(temporaryPath.c_str());
+            throw std::runtime_error("Could not move grid file into place: " + path);
+        }
+    }
+
+    Grid* Grid::mapFile(const std::string& path) {
+        int fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) {
+            throw std::runtime_error("Could not open grid file: " + path);
+        }
+        struct stat fileStat;
+        if (fstat(fileDescriptor, &fileStat) != 0 || (uint64_t)fileStat.st_size < sizeof(GridFileHeader)) {
+            close(fileDescriptor);
+            throw std::runtime_error("Grid file too small: " + path);
+        }
+        size_t length = fileStat.st_size;
+        void* address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        close(fileDescriptor);
+        if (address == MAP_FAILED) {
+            throw std::runtime_error("Could not map grid file: " + path);
+        }
+
+        // the header must describe exactly the layout we would have written
+        const GridFileHeader* header = static_cast<const GridFileHeader*>(address);
+        GridFileHeader expected = gridFileLayout(header->vertexCount, header->neighborCount, header->spatialResolution, header->reordered != 0);
+        if (std::memcmp(header, &expected, sizeof(GridFileHeader)) != 0 || expected.fileSize != length) {
+            munmap(address, length);
+            throw std::runtime_error("Grid file is from an incompatible build or is corrupt: " + path);
+        }
+
+        Grid* grid = new Grid();
+        const char* base = static_cast<const char*>(address);
+        grid->mappedAddress = address;
+        grid->mappedLength = length;
+        grid->vertexCount = header->vertexCount;
+        grid->spatialResolution = header->spatialResolution;
+        grid->positionData = reinterpret_cast<const Vec3*>(base + header->positionsOffset);
+        grid->neighborCenterData = reinterpret_cast<const Vec3*>(base + header->neighborCentersOffset);
+        grid->neighborOffsetData = reinterpret_cast<const uint32_t*>(base + header->neighborOffsetsOffset);
+        grid->neighborIndexData = reinterpret_cast<const uint32_t*>(base + header->neighborIndicesOffset);
+        grid->edgeDirectionData = reinterpret_cast<const Vec3*>(base + header->edgeDirectionsOffset);
+        grid->edgeLengthData = reinterpret_cast<const wb_float*>(base + header->edgeLengthsOffset);
+        grid->cellRadiusData = reinterpret_cast<const wb_float*>(base + header->cellRadiiOffset);
+        grid->spatialSeedData = reinterpret_cast<const uint32_t*>(base + header->spatialSeedsOffset);
+        if (header->reordered) {
+            grid->originalIndexData = reinterpret_cast<const uint32_t*>(base + header->originalIndicesOffset);
+            grid->vertexForOriginalData = reinterpret_cast<const uint32_t*>(base + header->vertexForOriginalOffset);
+        }
+        // every query indexes through these without checks, a stale or damaged cache must not get that far
+        if (!grid->hasValidMappedIndices(header->neighborCount)) {
+            delete grid;
+            throw std::runtime_error("Grid file neighbor or seed indices are out of range: " + path);
+        }
+        grid->createHandles();
+        return grid;
+    }
 
-        return depthNeighbors;
+    bool Grid::hasValidMappedIndices(uint32_t neighborCount) const {
+        if (vertexCount == 0) {
+            return neighborCount == 0;
+        }
+        if (spatialResolution == 0 || neighborOffsetData[0] != 0 || neighborOffsetData[vertexCount] != neighborCount) {
+            return false;
+        }
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            if (neighborOffsetData[index] > neighborOffsetData[index + 1]) {
+                return false;
+            }
+        }
+        for (uint32_t offset = 0; offset < neighborCount; offset++) {
+            if (neighborIndexData[offset] >= vertexCount) {
+                return false;
+            }
+        }
+        uint64_t bucketCount = 6 * (uint64_t)spatialResolution * spatialResolution;
+        for (uint64_t bucket = 0; bucket < bucketCount; bucket++) {
+            if (spatialSeedData[bucket] >= vertexCount) {
+                return false;
+            }
+        }
+        if (originalIndexData != nullptr) {
+            for (uint32_t index = 0; index < vertexCount; index++) {
+                if (originalIndexData[index] >= vertexCount || vertexForOriginalData[index] >= vertexCount) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+/*************** Locality Reordering ***************/
+    // position of (x, y) along a Hilbert curve filling a side x side square, side a power of two
+    static uint64_t hilbertDistance(uint32_t side, uint32_t x, uint32_t y) {
+        uint64_t distance = 0;
+        for (uint32_t half = side / 2; half > 0; half /= 2) {
+            uint32_t rx = (x & half) > 0;
+            uint32_t ry = (y & half) > 0;
+            distance += (uint64_t)half * half * ((3 * rx) ^ ry);
+            // rotate the quadrant so the curve stays continuous
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return distance;
+    }
+
+    void Grid::reorderForLocality() {
+        if (this->isMapped()) {
+            throw std::logic_error("Cannot reorder a mapped grid");
+        }
+        // sort by cube face, then by Hilbert distance within the face
+        const uint32_t curveSide = 1 << 16;
+        std::vector<uint64_t> curveKeys(vertexCount);
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            wb_float u, v, major;
+            uint32_t face = cubeFace(positions[index], u, v, major);
+            wb_float scale = major > 0 ? 0.5 * curveSide / major : 0;
+            wb_float fu = (u + major) * scale;
+            wb_float fv = (v + major) * scale;
+            uint32_t x = fu <= 0 ? 0 : std::min(curveSide - 1, (uint32_t)fu);
+            uint32_t y = fv <= 0 ? 0 : std::min(curveSide - 1, (uint32_t)fv);
+            curveKeys[index] = ((uint64_t)face << 32) | hilbertDistance(curveSide, x, y);
+        }
+        // order[new index] = old index
+        std::vector<uint32_t> order(vertexCount);
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            order[index] = index;
+        }
+        std::sort(order.begin(), order.end(), [&curveKeys](uint32_t a, uint32_t b) {
+            return curveKeys[a] < curveKeys[b] || (curveKeys[a] == curveKeys[b] && a < b);
+        });
+        std::vector<uint64_t>().swap(curveKeys);
+        std::vector<uint32_t> newIndexOf(vertexCount);
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            newIndexOf[order[index]] = index;
+        }
+
+        // permute the per vertex arrays, neighbor rings keep their winding
+        std::vector<Vec3> newPositions(vertexCount);
+        std::vector<Vec3> newCenters(vertexCount);
+        std::vector<uint32_t> newOffsets(vertexCount + 1);
+        std::vector<uint32_t> newIndices(neighborIndices.size());
+        uint32_t totalNeighbors = 0;
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            uint32_t old = order[index];
+            newPositions[index] = positions[old];
+            newCenters[index] = neighborCenters[old];
+            newOffsets[index] = totalNeighbors;
+            for (uint32_t offset = neighborOffsets[old]; offset < neighborOffsets[old + 1]; offset++) {
+                newIndices[totalNeighbors++] = newIndexOf[neighborIndices[offset]];
+            }
+        }
+        newOffsets[vertexCount] = totalNeighbors;
+        positions.swap(newPositions);
+        neighborCenters.swap(newCenters);
+        neighborOffsets.swap(newOffsets);
+        neighborIndices.swap(newIndices);
+        for (uint32_t& seed : spatialSeeds) {
+            seed = newIndexOf[seed];
+        }
+        this->buildEdgeGeometry();
+
+        // compose with any earlier reordering so the original order is never lost
+        std::vector<uint32_t> newOriginal(vertexCount);
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            newOriginal[index] = this->get_originalIndex(order[index]);
+        }
+        originalIndices.swap(newOriginal);
+        vertexForOriginal.resize(vertexCount);
+        for (uint32_t index = 0; index < vertexCount; index++) {
+            vertexForOriginal[originalIndices[index]] = index;
+        }
+        this->bindStorage();
+    }
+
+    void Grid::createHandles() {
+        verts.resize(vertexCount);
+        for (uint32_t index = 0; index < verts.size(); index++) {
+            verts[index].grid = this;
+            verts[index].index = index;
+        }
+    }
+
+    GridNeighbors Grid::get_ring(uint32_t center, uint32_t depth, GridRingScratch& scratch) const {
+        std::vector<uint32_t>& visited = scratch.visitedGeneration;
+        if (visited.size() != vertexCount) {
+            visited.assign(vertexCount, 0);
+            scratch.generation = 0;
+        }
+        scratch.generation++;
+        if (scratch.generation == 0) {
+            // wrapped, old stamps could collide
+            std::fill(visited.begin(), visited.end(), 0);
+            scratch.generation = 1;
+        }
+        uint32_t stamp = scratch.generation;
+
+        std::vector<uint32_t>& ring = scratch.ring;
+        ring.clear();
+        ring.push_back(center);
+        visited[center] = stamp;
+        size_t layerBegin = 0;
+        for (uint32_t layer = 0; layer < depth; layer++) {
+            size_t layerEnd = ring.size();
+            for (size_t ringIndex = layerBegin; ringIndex < layerEnd; ringIndex++) {
+                uint32_t vertex = ring[ringIndex];
+                for (uint32_t offset = neighborOffsetData[vertex]; offset < neighborOffsetData[vertex + 1]; offset++) {
+                    uint32_t neighbor = neighborIndexData[offset];
+                    if (visited[neighbor] != stamp) {
+                        visited[neighbor] = stamp;
+                        ring.push_back(neighbor);
+                    }
+                }
+            }
+            layerBegin = layerEnd;
+        }
+        return GridNeighbors(ring.data(), ring.data() + ring.size());
     }
 
-}
\ No newline at end of file
+}
@@ -3,74 +3,277 @@
 //  WorldGenerator
 //
 //  Grid structure used to represent the geometry of the world and plates
-//  Currently must be generated by an external program (WingedGrid, written in Go)
+//  Either generated natively as a subdivided icosahedron, or uploaded from an external program (WingedGrid, written in Go)
+//
+//  Topology is held in a single compressed sparse row block: neighborOffsets[i] to neighborOffsets[i+1]
+//  indexes the run of neighborIndices belonging to vertex i. Positions and neighbor centers are contiguous arrays
+//  Edge geometry (unit direction and chord length per directed edge, parallel to neighborIndices) and a per vertex
+//  cell radius are computed once at load, the grid never changes afterwards
+//
+//  Nearest vertex queries go through a cube map spatial index: each face of the unit cube is split into
+//  spatialResolution^2 buckets, each remembering the grid vertex nearest its center. A query projects onto
+//  the cube, takes that bucket's vertex as a seed, and walks downhill through neighbors (usually 0-2 steps)
+//
+//  A finished grid can be written to a binary cache file and mapped back read only. The file is a fixed header
+//  followed by 64 byte aligned positions, neighbor centers, neighbor offsets, neighbor indices, edge directions,
+//  edge lengths, cell radii, spatial seeds and, for reordered grids, the permutation, all in native byte order and wb_float width. A mapped grid reads straight out of the (shared) page cache
+//
+//  Vertices can optionally be renumbered along a Hilbert curve over the cube map so that cells near each other
+//  on the sphere are near each other in memory. The permutation is kept so output can go back out in the order
+//  the grid was uploaded in
 
 
 #ifndef Grid_hpp
 #define Grid_hpp
 
+#include <string>
+#include <vector>
+#include <unordered_map>
+
 #include "api/Basic.pb.h"
 #include "math.hpp"
 
 namespace WorldBuilder {
-    class GridVertex;
-    class Grid {
-    /*************** Member Variables ***************/
-    private:
-        std::vector<GridVertex> verts;
-        
+    class Grid;
+
+    /*************** Grid Neighbors ***************/
+    /*  Range over the neighbor indices of a single vertex
+     *  Points directly into the Grid's CSR block, valid for the lifetime of the Grid
+     */
+    class GridNeighbors {
+        const uint32_t* first;
+        const uint32_t* last;
     public:
-        Grid(const api::Grid* wingedGrid);
-        Grid(uint32_t vertexCount);
-        
-        
-        void addGrpcGridPart(const api::Grid *theGrid);
-        
-        void buildCenters();
-        
-    /*************** Getters ***************/
-        uint32_t verts_size(){
-            return verts.size();
+        GridNeighbors(const uint32_t* begin, const uint32_t* end) : first(begin), last(end){};
+
+        const uint32_t* begin() const {
+            return first;
         }
-        const std::vector<GridVertex>& get_vertices(){
-            return verts;
+        const uint32_t* end() const {
+            return last;
+        }
+        size_t size() const {
+            return last - first;
+        }
+        uint32_t operator[](size_t idx) const {
+            return first[idx];
         }
     };
-    
-    
-    
-    
+
+    /*************** Grid Vertex ***************/
+    /*  Lightweight handle to a single vertex of the Grid
+     *  Holds no geometry of its own, all lookups go through the owning Grid's arrays
+     */
     class GridVertex {
         friend Grid;
     /*************** Member Variables  ***************/
     private:
+        const Grid* grid;
         uint32_t index;
-        Vec3 vector;
-        Vec3 neighborCenter;
-        std::vector<GridVertex *> neighbors;
-        
+
     public:
-        
+
     /*************** Getters ***************/
-        const Vec3 get_vector() const {
-            return this->vector;
-        }
+        const Vec3& get_vector() const;
         uint32_t get_index() const{
             return index;
         }
-        const std::vector<GridVertex *>& get_neighbors() const {
-            return neighbors;
+        GridNeighbors get_neighbors() const;
+        const Vec3& get_neighborCenter() const;
+        const Vec3 displacementFromCenter() const {
+            return get_vector() - get_neighborCenter();
+        }
+
+    };
+
+    /*************** Grid Ring Scratch ***************/
+    /*  Reusable working memory for Grid::get_ring
+     *  Visited vertices are stamped with a generation number, so nothing is cleared or allocated between queries
+     *  One per thread, each query invalidates the ring returned by the previous one
+     */
+    class GridRingScratch {
+        friend Grid;
+        std::vector<uint32_t> visitedGeneration;
+        uint32_t generation;
+        std::vector<uint32_t> ring;
+    public:
+        GridRingScratch() : generation(0){};
+    };
+
+    class Grid {
+    /*************** Member Variables ***************/
+    private:
+        uint32_t vertexCount;
+
+        // views used by all queries, point into the owned vectors below or into a mapped cache file
+        const Vec3* positionData;
+        const Vec3* neighborCenterData;
+        const uint32_t* neighborOffsetData;
+        const uint32_t* neighborIndexData;
+        const Vec3* edgeDirectionData;
+        const wb_float* edgeLengthData;
+        const wb_float* cellRadiusData;
+        const uint32_t* spatialSeedData;
+        const uint32_t* originalIndexData; // null unless reordered
+        const uint32_t* vertexForOriginalData; // null unless reordered
+
+        // owned storage, empty for mapped grids
+        std::vector<Vec3> positions;
+        std::vector<Vec3> neighborCenters;
+        std::vector<uint32_t> neighborOffsets; // vertex count + 1 entries
+        std::vector<uint32_t> neighborIndices;
+        std::vector<Vec3> edgeDirections; // from the neighbor toward the vertex
+        std::vector<wb_float> edgeLengths;
+        std::vector<wb_float> cellRadii;
+
+        std::vector<GridVertex> verts; // handles for code that still works with vertex pointers
+
+        // cube map spatial index, 6 faces of spatialResolution x spatialResolution buckets
+        uint32_t spatialResolution;
+        std::vector<uint32_t> spatialSeeds;
+
+        // locality reordering, current index to uploaded index and back
+        std::vector<uint32_t> originalIndices;
+        std::vector<uint32_t> vertexForOriginal;
+
+        // mapped cache file, if any
+        void* mappedAddress;
+        size_t mappedLength;
+
+        // neighbor runs received by addGrpcGridPart, compacted into the CSR block by buildCenters
+        std::vector<uint32_t> stagedNeighborCounts;
+        std::vector<uint32_t> stagedNeighborStarts;
+        std::vector<uint32_t> stagedNeighbors;
+
+        Grid();
+
+        void createHandles();
+        // offsets ascend to neighborCount, every neighbor, seed and permutation entry names a vertex
+        bool hasValidMappedIndices(uint32_t neighborCount) const;
+        void bindStorage();
+        void compactStagedNeighbors();
+        void buildEdgeGeometry();
+        void buildSpatialIndex();
+
+        static uint32_t cubeFace(const Vec3& location, wb_float& u, wb_float& v, wb_float& major);
+        uint32_t spatialBucket(const Vec3& location) const;
+        Vec3 spatialBucketCenter(uint32_t bucket) const;
+
+    public:
+        Grid(const api::Grid* wingedGrid);
+        Grid(uint32_t vertexCount);
+
+        // icosahedron with each edge split into 2^subdivisionLevel segments, 10*4^level + 2 vertices
+        // numbering is deterministic for a given level: 12 corners, then edge interiors, then face interiors
+        // neighbor rings are wound counter clockwise when viewed from outside the sphere
+        // the returned grid has finished loading
+        static Grid* icosphere(uint32_t subdivisionLevel);
+
+        // maps a file written by writeFile, read only, throws std::runtime_error if it cannot be used
+        // the returned grid has finished loading
+        static Grid* mapFile(const std::string& path);
+
+        ~Grid();
+
+        // handles point back into the grid, so it must stay put
+        Grid(const Grid&) = delete;
+        Grid& operator=(const Grid&) = delete;
+
+        void addGrpcGridPart(const api::Grid *theGrid);
+
+        // finishes loading, must be called after construction or the last addGrpcGridPart
+        // compacts the topology and builds centers, edge geometry and the spatial index
+        void finishLoading();
+
+        void buildCenters();
+
+        // dumps a finished grid for mapFile, written to a temporary then renamed into place
+        // so processes mapping the same path never see a partial file
+        void writeFile(const std::string& path) const;
+        bool isMapped() const {
+            return mappedAddress != nullptr;
+        }
+
+        // renumbers a finished grid along a Hilbert curve for cache locality, not available on mapped grids
+        // must happen before anything holds on to vertex indices
+        void reorderForLocality();
+
+    /*************** Queries ***************/
+        // nearest vertex to a point on the unit sphere, constant time
+        uint32_t nearestIndex(const Vec3& location) const;
+        // nearestIndex for many points, buckets are found for the whole batch before any walking,
+        // four at a time with AVX2, the walks themselves are scalar
+        void nearestIndices(const Vec3* locations, uint32_t count, uint32_t* nearest) const;
+        // walks downhill from start until no neighbor is closer, at most maxSteps moves
+        // returns true if a local nearest was reached within the step limit
+        bool descendToNearest(const Vec3& location, uint32_t start, uint32_t maxSteps, uint32_t& nearest) const;
+        // every vertex within depth steps of center, center first then breadth first by layer
+        // the returned range lives in the scratch and is valid until its next query
+        GridNeighbors get_ring(uint32_t center, uint32_t depth, GridRingScratch& scratch) const;
+
+    /*************** Getters ***************/
+        uint32_t verts_size() const {
+            return vertexCount;
+        }
+        const std::vector<GridVertex>& get_vertices() const {
+            return verts;
         }
-        const Vec3 get_neighborCenter() const {
-            return neighborCenter;
+
+        const Vec3& get_position(uint32_t index) const {
+            return positionData[index];
         }
-        const Vec3 displacementFromCenter() const {
-            return vector - neighborCenter;
+        const Vec3& get_neighborCenter(uint32_t index) const {
+            return neighborCenterData[index];
+        }
+        GridNeighbors get_neighbors(uint32_t index) const {
+            return GridNeighbors(neighborIndexData + neighborOffsetData[index], neighborIndexData + neighborOffsetData[index + 1]);
+        }
+        uint32_t get_neighborCount(uint32_t index) const {
+            return neighborOffsetData[index + 1] - neighborOffsetData[index];
+        }
+        // parallel to get_neighbors(index), unit vectors pointing from each neighbor toward the vertex
+        const Vec3* get_edgeDirections(uint32_t index) const {
+            return edgeDirectionData + neighborOffsetData[index];
+        }
+        // parallel to get_neighbors(index), chord length to each neighbor
+        const wb_float* get_edgeLengths(uint32_t index) const {
+            return edgeLengthData + neighborOffsetData[index];
+        }
+        // half the chord to the first neighbor, cells are roughly uniform nearby
+        wb_float get_cellRadius(uint32_t index) const {
+            return cellRadiusData[index];
         }
 
-        std::unordered_map<uint32_t, GridVertex *> neighborsByDepth(uint32_t dist) const;
+        // index the vertex had when uploaded or generated, same as index unless reordered
+        uint32_t get_originalIndex(uint32_t index) const {
+            return originalIndexData == nullptr ? index : originalIndexData[index];
+        }
+        uint32_t get_vertexForOriginal(uint32_t originalIndex) const {
+            return vertexForOriginalData == nullptr ? originalIndex : vertexForOriginalData[originalIndex];
+        }
 
+        // raw arrays for kernels that sweep the whole grid
+        const Vec3* get_positions() const {
+            return positionData;
+        }
+        const uint32_t* get_neighborOffsets() const {
+            return neighborOffsetData;
+        }
+        const uint32_t* get_neighborIndices() const {
+            return neighborIndexData;
+        }
     };
+
+    /*************** Grid Vertex Getters ***************/
+    inline const Vec3& GridVertex::get_vector() const {
+        return grid->get_position(index);
+    }
+    inline GridNeighbors GridVertex::get_neighbors() const {
+        return grid->get_neighbors(index);
+    }
+    inline const Vec3& GridVertex::get_neighborCenter() const {
+        return grid->get_neighborCenter(index);
+    }
 }
 
 #endif /* Grid_hpp */
@@ -26,82 +26,96 @@ namespace WorldBuilder {
     }
     
     void AngularMomentumTracker::commitTransfer(){
-        std::unordered_map<uint32_t, Vec3> newMomentumPoles;
-        newMomentumPoles.reserve(this->plates.size());
-        
-        for (auto&& plateIt : this->plates) {
-            uint32_t index = plateIt.first;
-            std::shared_ptr<Plate>& plate = plateIt.second;
-            newMomentumPoles[index] = plate->pole * this->startingMomentum[index];
-            if (badTransfer(newMomentumPoles[index])) {
-                //std::printf("Bad new pole at start\n");
+        size_t plateCount = this->plates.size();
+        // one array per component so the loops over a matrix row vectorize
+        std::vector<wb_float> poles[3];
+        std::vector<wb_float> newMomentumPoles[3];
+        for (int component = 0; component < 3; component++) {
+            poles[component].resize(plateCount);
+            newMomentumPoles[component].resize(plateCount);
+        }
+        for (size_t slot = 0; slot < plateCount; slot++) {
+            for (int component = 0; component < 3; component++) {
+                poles[component][slot] = this->plates[slot]->pole[component];
+                newMomentumPoles[component][slot] = poles[component][slot] * this->startingMomentum[slot];
             }
         }
-        for (auto&& sourcePlateIt : this->plates) {
-            uint32_t sourcePlateIndex = sourcePlateIt.first;
-            for (auto&& destinationPlateIt : this->plates) {
-                uint32_t destinationPlateIndex = destinationPlateIt.first;
-                if (sourcePlateIndex != destinationPlateIndex) {
-                    Vec3 transferPole = this->plates[sourcePlateIndex]->pole * this->momentumTransfers[((uint64_t)sourcePlateIndex << 32) | destinationPlateIndex];
-                    // check if bad transfer!!!!!!!
-                    if (badTransfer(transferPole)) {
-                        //std::cout << "Bad mass transfer" << std::endl;
-                    }
-                    
-                    // add to destination
-                    newMomentumPoles[destinationPlateIndex] = newMomentumPoles[destinationPlateIndex] + transferPole;
-                    
-                    // subtract from source
-                    newMomentumPoles[sourcePlateIndex] = newMomentumPoles[sourcePlateIndex] - transferPole;
-                    
+        
+        // mass transfer, momentum moves with the source plate's pole, the diagonal is always zero
+        for (size_t source = 0; source < plateCount; source++) {
+            const wb_float* transfers = &this->momentumTransfers[source * plateCount];
+            wb_float transferTotal = 0;
+            for (size_t destination = 0; destination < plateCount; destination++) {
+                transferTotal += transfers[destination];
+            }
+            for (int component = 0; component < 3; component++) {
+                wb_float sourcePole = poles[component][source];
+                wb_float* newPoles = newMomentumPoles[component].data();
+                // add to destination
+                for (size_t destination = 0; destination < plateCount; destination++) {
+                    newPoles[destination] += sourcePole * transfers[destination];
                 }
+                // subtract from source
+                newPoles[source] -= sourcePole * transferTotal;
             }
         } // end mass transfer
         
         // tranfer momentum from friction
-        for (auto firstPlateIt = this->plates.begin(), end = this->plates.end(); firstPlateIt != end; firstPlateIt++) {
-            uint32_t firstPlateIndex = firstPlateIt->first;
-            std::shared_ptr<Plate>& firstPlate = firstPlateIt->second;
-            auto secondPlateIt = firstPlateIt;
-            secondPlateIt++;
-            for (; secondPlateIt != end; secondPlateIt++) {
-                uint32_t secondPlateIndex = secondPlateIt->first;
-                std::shared_ptr<Plate>& secondPlate = secondPlateIt->second;
-                
-                size_t combinedCount = this->collidedCellCount[((uint64_t)firstPlateIndex << 32) | secondPlateIndex] + this->collidedCellCount[((uint64_t) secondPlateIndex) | firstPlateIndex];
-                if (combinedCount != 0 && this->startingCellCount[firstPlateIndex] != 0 && this->startingCellCount[secondPlateIndex] != 0) {
-                    wb_float collisionFractionI = (wb_float)combinedCount / (wb_float)this->startingCellCount[firstPlateIndex] / 2;
-                    wb_float collisionFractionJ = (wb_float)combinedCount / (wb_float)this->startingCellCount[secondPlateIndex] / 2;
-                    
-                    // to i we are subtracting a portion of i and adding a portion of j
-                    Vec3 transferPole = secondPlate->pole * (frictionCoeff*this->startingMomentum[firstPlateIndex]*collisionFractionI) -
-                                        firstPlate->pole * (frictionCoeff*this->startingMomentum[secondPlateIndex]*collisionFractionJ);
-                    
-                    if (badTransfer(transferPole)) {
-                        //std::cout << "Bad friction transfer" << std::endl;
-                    }
-                    
-                    // add to plate i
-                    newMomentumPoles[firstPlateIndex] = newMomentumPoles[firstPlateIndex] + transferPole;
-                    
-                    // subtract from plate j
-                    newMomentumPoles[secondPlateIndex] = newMomentumPoles[secondPlateIndex] - transferPole;
+        // frictionShare is the part of a plate's momentum one collided cell moves, zero for plates that started empty
+        std::vector<wb_float> frictionShare(plateCount, 0);
+        for (size_t slot = 0; slot < plateCount; slot++) {
+            if (this->startingCellCount[slot] != 0) {
+                frictionShare[slot] = frictionCoeff * this->startingMomentum[slot] / (wb_float)this->startingCellCount[slot] / 2;
+            }
+        }
+        std::vector<wb_float> combinedCount(plateCount * plateCount, 0);
+        for (size_t first = 0; first < plateCount; first++) {
+            if (this->startingCellCount[first] == 0) {
+                continue;
+            }
+            for (size_t second = first + 1; second < plateCount; second++) {
+                if (this->startingCellCount[second] != 0) {
+                    combinedCount[first * plateCount + second] = this->collidedCellCount[first * plateCount + second].load(std::memory_order_relaxed) +
+                                                                 this->collidedCellCount[second * plateCount + first].load(std::memory_order_relaxed);
+                }
+            }
+        }
+        for (size_t first = 0; first < plateCount; first++) {
+            const wb_float* counts = &combinedCount[first * plateCount];
+            for (int component = 0; component < 3; component++) {
+                const wb_float* componentPoles = poles[component].data();
+                wb_float* newPoles = newMomentumPoles[component].data();
+                wb_float firstPole = componentPoles[first];
+                wb_float firstShare = frictionShare[first];
+                wb_float firstTotal = 0;
+                for (size_t second = first + 1; second < plateCount; second++) {
+                    // to first we are adding a portion of second and subtracting a portion of first
+                    wb_float transfer = counts[second] * (componentPoles[second] * firstShare - firstPole * frictionShare[second]);
+                    firstTotal += transfer;
+                    newPoles[second] -= transfer;
                 }
+                newPoles[first] += firstTotal;
             }
         }
         
         // calculate new poles
-        for (auto&& plateIt : this->plates){
-            uint32_t index = plateIt.first;
-            std::shared_ptr<Plate>& plate = plateIt.second;
+        for (size_t slot = 0; slot < plateCount; slot++){
+            std::shared_ptr<Plate>& plate = this->plates[slot];
+            Vec3 newMomentumPole;
+            for (int component = 0; component < 3; component++) {
+                newMomentumPole.coords[component] = newMomentumPoles[component][slot];
+            }
+            if (badTransfer(newMomentumPole)) {
+                //std::cout << "Bad momentum transfer" << std::endl;
+            }
             wb_float newMagnitude;
             Vec3 newPole;
-            std::tie(newPole, newMagnitude) = math::normalize3VectorWithScale(newMomentumPoles[index]);
+            std::tie(newPole, newMagnitude) = math::normalize3VectorWithScale(newMomentumPole);
             if (newMagnitude == 0 || std::isnan(newMagnitude)) {
                 //std::cout << "Bad angular momentum magnitude on commit" << std::endl;
-                std::printf("Starting Mag: %f\n", this->startingMomentum[index]);
-                std::printf("New Momentum Pole: (%f, %f, %f)\n", newMomentumPoles[index][0], newMomentumPoles[index][1], newMomentumPoles[index][2]);
-                std::printf("Plate Index: %u\n", index);
+                std::printf("Starting Mag: %f\n", this->startingMomentum[slot]);
+                std::printf("New Momentum Pole: (%f, %f, %f)\n", newMomentumPole[0], newMomentumPole[1], newMomentumPole[2]);
+                std::printf("Plate Index: %u\n", plate->id);
                 newPole.coords[0] = 0;
                 newPole.coords[1] = 0;
                 newPole.coords[2] = 1;
@@ -109,16 +123,8 @@ namespace WorldBuilder {
             }
             plate->pole = newPole;
             
-            // update cell radii with new pole
-            plate->updateCellRadii();
-            
-            wb_float poleChangeMomentumMagnitude = 0;
-            for (auto&& cellIt : plate->cells)
-            {
-                std::shared_ptr<PlateCell>& cell = cellIt.second;
-                // TODO may be able to get rid of angular speed multiplication here if we don't scale by it just below
-                poleChangeMomentumMagnitude += cell->poleRadius * cell->rock.mass() * plate->angularSpeed;
-            }
+            // momentum about the new pole at the old speed
+            wb_float poleChangeMomentumMagnitude = plate->momentumAbout(newPole);
             
             plate->angularSpeed = plate->angularSpeed * newMagnitude / poleChangeMomentumMagnitude;
             
@@ -131,55 +137,75 @@ namespace WorldBuilder {
     
     
 /**************** Modifiers ****************/
-    void AngularMomentumTracker::transferMomentumOfCell(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination, std::shared_ptr<PlateCell> cell){
-        // transfers the entire momentum from the cell
-        this->momentumTransfers[((uint64_t)source->id << 32) | destination->id] += cell->rock.mass() * cell->poleRadius * source->angularSpeed;
+    uint32_t AngularMomentumTracker::entry(const Plate& source, const Plate& destination) const {
+        if (source.id == destination.id || source.id >= this->plateSlots.size() || destination.id >= this->plateSlots.size()) {
+            return noSlot;
+        }
+        uint32_t sourceSlot = this->plateSlots[source.id];
+        uint32_t destinationSlot = this->plateSlots[destination.id];
+        if (sourceSlot == noSlot || destinationSlot == noSlot) {
+            return noSlot;
+        }
+        return sourceSlot * this->plates.size() + destinationSlot;
     }
     
-
+    void AngularMomentumTracker::transferMomentumOfCell(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination, const PlateCell& cell){
+        // transfers the entire momentum from the cell
+        uint32_t pair = this->entry(*source, *destination);
+        if (pair != noSlot) {
+            this->momentumTransfers[pair] += source->cellMomentum(cell);
+        }
+    }
     
     void AngularMomentumTracker::addCollision(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination) {
-        if (source->id == destination->id) {
-            // something's fishy
-            return;
+        uint32_t pair = this->entry(*source, *destination);
+        if (pair != noSlot) {
+            this->collidedCellCount[pair].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    
+    void AngularMomentumTracker::merge(const MomentumBuffer& buffer) {
+        for (auto&& transfer : buffer.transfers) {
+            this->momentumTransfers[transfer.first] += transfer.second;
         }
-        this->collidedCellCount[((uint64_t)source->id) | destination->id] += 1;
+    }
+    
+/**************** Momentum Buffer ****************/
+    // same entries and amounts as the tracker's own modifiers
+    void MomentumBuffer::transferMomentumOfCell(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination, const PlateCell& cell){
+        uint32_t pair = this->tracker->entry(*source, *destination);
+        if (pair != AngularMomentumTracker::noSlot) {
+            this->transfers.push_back(std::make_pair(pair, source->cellMomentum(cell)));
+        }
+    }
+    
+    void MomentumBuffer::addCollision(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination) {
+        this->tracker->addCollision(source, destination);
+    }
+    
+    void MomentumBuffer::clear() {
+        this->transfers.clear();
     }
     
 /**************** Constructors ****************/
-    AngularMomentumTracker::AngularMomentumTracker(std::unordered_map<uint32_t, std::shared_ptr<Plate>> iPlates){
-        this->plates = iPlates;
-        
-        this->startingMomentum.reserve(iPlates.size());
-        this->startingCellCount.reserve(iPlates.size());
-        this->momentumTransfers.reserve(iPlates.size() * iPlates.size());
-        this->collidedCellCount.reserve(iPlates.size() * iPlates.size());
-        
-        // initialize with zero
-        for (auto&& plateIt : this->plates) {
-            for (auto&& secondPlateIt : this->plates) {
-                this->momentumTransfers[((uint64_t)plateIt.second->id << 32) | secondPlateIt.second->id] = 0;
-                this->collidedCellCount[((uint64_t)plateIt.second->id << 32) | secondPlateIt.second->id] = 0;
+    const uint32_t AngularMomentumTracker::noSlot;
+    
+    AngularMomentumTracker::AngularMomentumTracker(const std::unordered_map<uint32_t, std::shared_ptr<Plate>>& iPlates) : momentumTransfers(iPlates.size() * iPlates.size(), 0), collidedCellCount(iPlates.size() * iPlates.size()), startingMomentum(iPlates.size(), 0), startingCellCount(iPlates.size(), 0) {
+        this->plates.reserve(iPlates.size());
+        for (auto&& plateIt : iPlates) {
+            std::shared_ptr<Plate> plate = plateIt.second;
+            if (plate->id >= this->plateSlots.size()) {
+                this->plateSlots.resize(plate->id + 1, noSlot);
             }
+            this->plateSlots[plate->id] = this->plates.size();
+            this->plates.push_back(plate);
         }
-        
         // calculate starting angular momentum
         // calculate starting surface cell count
-        for (auto&& plateIt : this->plates) {
-            std::shared_ptr<Plate>& plate = plateIt.second;
-            this->startingCellCount[plate->id] = plate->cells.size();
-            // update cell radii for momentum calculations
-            plate->updateCellRadii();
-            wb_float momentumMagnitude = 0;
-            for (auto&& cellIt : plate->cells)
-            {
-                std::shared_ptr<PlateCell>& cell = cellIt.second;
-                wb_float mag = cell->poleRadius * cell->rock.mass() * plate->angularSpeed;
-                if (std::isfinite(mag)) {
-                    momentumMagnitude += cell->poleRadius * cell->rock.mass() * plate->angularSpeed;
-                }
-            }
-            this->startingMomentum[plate->id] = momentumMagnitude;
+        for (size_t slot = 0; slot < this->plates.size(); slot++) {
+            std::shared_ptr<Plate>& plate = this->plates[slot];
+            this->startingCellCount[slot] = plate->cells.size();
+            this->startingMomentum[slot] = plate->momentumAbout(plate->pole);
         }
     }
-}
\ No newline at end of file
+}
@@ -4,26 +4,66 @@
 //
 //  Tracks angular momentum changes such that Plate angular velocites can be recalculated during the transition phase
 //  Allows for a momentum conservative system
+//
+//  Momentum is the true angular momentum, sum m r^2 w (see Plate::momentumAbout), both for whole plates and for the
+//  cells moved between them. Up to the inertia tensor it was sum m r w, which moved plates at different speeds
+//
+//  Plates tracked at construction get compact slots 0..P-1 in plate map order, transfers and collisions are
+//  P x P matrices with the source plate's slot as the row and the destination plate's slot as the column
 
 
 #ifndef MomentumTracker_hpp
 #define MomentumTracker_hpp
 
+#include <atomic>
+#include <limits>
+
 #include "Plate.hpp"
 
 namespace WorldBuilder {
+    class AngularMomentumTracker;
+    
+    /***************  Momentum Buffer ***************/
+    /*  Momentum transfers gathered away from the tracker, so each thread of a parallel loop can keep its own
+     *  Transfers are kept in the order they happened and replayed by AngularMomentumTracker::merge,
+     *  merging buffers in loop order gives the same sums as running the loop serially
+     *  Collisions are whole counts, so they go straight to the tracker's atomic counters
+     */
+    class MomentumBuffer {
+        friend class AngularMomentumTracker;
+        AngularMomentumTracker* tracker;
+        std::vector<std::pair<uint32_t, wb_float>> transfers; // matrix entry and amount
+    public:
+        MomentumBuffer(AngularMomentumTracker& ourTracker) : tracker(&ourTracker){};
+        
+        void transferMomentumOfCell(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination, const PlateCell& cell);
+        void addCollision(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination);
+        void clear();
+    };
+    
     class AngularMomentumTracker {
-        std::unordered_map<uint32_t, std::shared_ptr<Plate>> plates;
-        std::unordered_map<uint64_t, wb_float> momentumTransfers; // from plate with id of top 32 bits to plate of lower 32 bits
-        std::unordered_map<uint64_t, size_t> collidedCellCount; // from plate with id of top 32 bits to plate of lower 32 bits
-        std::unordered_map<uint32_t, wb_float> startingMomentum;
-        std::unordered_map<uint32_t, size_t> startingCellCount;
+        friend class MomentumBuffer;
+        static const uint32_t noSlot = std::numeric_limits<uint32_t>::max();
+        
+        std::vector<std::shared_ptr<Plate>> plates; // by slot
+        std::vector<uint32_t> plateSlots; // by plate id, noSlot for plates created after the tracker
+        std::vector<wb_float> momentumTransfers; // P x P, source row to destination column
+        std::vector<std::atomic<uint32_t>> collidedCellCount; // P x P, source row to destination column
+        std::vector<wb_float> startingMomentum; // by slot
+        std::vector<size_t> startingCellCount; // by slot
+        
+        // matrix entry for the pair, noSlot if either plate isn't tracked or both are the same plate
+        uint32_t entry(const Plate& source, const Plate& destination) const;
     public:
-        AngularMomentumTracker(std::unordered_map<uint32_t, std::shared_ptr<Plate>> plates);
+        AngularMomentumTracker(const std::unordered_map<uint32_t, std::shared_ptr<Plate>>& plates);
+        AngularMomentumTracker(const AngularMomentumTracker&) = delete;
         
         // momentum modification
-        void transferMomentumOfCell(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination, std::shared_ptr<PlateCell> cell);
+        void transferMomentumOfCell(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination, const PlateCell& cell);
+        // safe to call from any thread
         void addCollision(std::shared_ptr<Plate> source, std::shared_ptr<Plate> destination);
+        // apply every transfer a buffer gathered
+        void merge(const MomentumBuffer& buffer);
         
         void commitTransfer();
         
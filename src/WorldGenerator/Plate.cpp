@@ -5,6 +5,7 @@
 
 #include "Plate.hpp"
 
+#include <algorithm>
 #include <math.h>
 
 namespace WorldBuilder {
@@ -12,9 +13,9 @@ namespace WorldBuilder {
     size_t Plate::surfaceSize() const{
         size_t size = 0;
         
-        for (auto cellIt = this->cells.begin(); cellIt != this->cells.end(); cellIt++)
+        for (auto&& cell : this->cells)
         {
-            if (!cellIt->second->isSubducted() && !cellIt->second->rock.isEmpty()) {
+            if (!cell.isSubducted() && !cell.rock.isEmpty()) {
                 size++;
             }
         }
@@ -22,26 +23,28 @@ namespace WorldBuilder {
     }
     
     void Plate::homeostasis(const WorldAttributes worldAttributes, wb_float timestep){
-        for (auto cellIt = this->cells.begin(); cellIt != this->cells.end(); cellIt++)
-        {
-            cellIt->second->homeostasis(worldAttributes, timestep);
-        }
+        this->cells.homeostasis(worldAttributes, timestep);
     }
     
     void Plate::move(wb_float timestep){
-        Matrix3x3 timestepRotation = math::rotationMatrixAboutAxis(this->pole, this->angularSpeed*timestep);
-        this->rotationMatrix = math::matrixMul(this->rotationMatrix, timestepRotation);
+        Quaternion timestepRotation = math::quaternionAboutAxis(this->pole, this->angularSpeed*timestep);
+        // renormalized every step, so rounding never builds up into a scale or shear
+        this->set_orientation(math::normalizeQuaternion(math::quaternionMul(this->orientation, timestepRotation)));
     }
     
-    void Plate::updateCellRadii(){
-        for (auto cellIt = this->cells.begin(); cellIt != this->cells.end(); cellIt++)
-        {
-            cellIt->second->poleRadius = math::distanceFromPole(cellIt->second->get_vertex()->get_vector(), this->pole);
-        }
+    void Plate::set_orientation(const Quaternion& ourOrientation){
+        this->orientation = ourOrientation;
+        this->rotationMatrix = math::rotationMatrixFromQuaternion(ourOrientation);
+        this->inverseRotation = math::transpose(this->rotationMatrix);
+    }
+    
+    wb_float Plate::cellMomentum(const PlateCell& cell) const {
+        wb_float x = cell.get_vertex()->get_vector().dot(this->pole);
+        wb_float radiusSquared = std::max((wb_float)0, 1 - x*x);
+        return cell.rock.mass() * radiusSquared * this->angularSpeed;
     }
     
-    Plate::Plate(uint32_t initialCellCount, uint32_t ourId) : rotationMatrix(math::identityMatrix()), centerVertex(nullptr), maxEdgeAngle(0), id(ourId) {
-        this->cells.reserve(initialCellCount);
+    Plate::Plate(uint32_t gridSize, uint32_t ourId) : rotationMatrix(math::identityMatrix()), inverseRotation(math::identityMatrix()), centerVertex(nullptr), maxEdgeAngle(0), id(ourId), cells(gridSize) {
         this->angularSpeed = 0;
     }
     
@@ -11,14 +11,16 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "Defines.h"
 #include "PlateCell.hpp"
+#include "PlateCellStore.hpp"
 
 namespace WorldBuilder {
     /***************  Plate ***************/
     /*  Represents a tectonic plate
-     *  Tracks movement via a rotation matrix
+     *  Tracks movement via a unit quaternion, with its rotation matrices cached for the many point transforms
      *  Contains relevent PlateCells
      *  Tracks angular momentum
      *
@@ -29,7 +31,9 @@ namespace WorldBuilder {
     private:
         Vec3 pole;
         wb_float angularSpeed;
-        Matrix3x3 rotationMatrix;
+        Quaternion orientation; // local to world
+        Matrix3x3 rotationMatrix; // orientation as a matrix, local to world
+        Matrix3x3 inverseRotation; // world to local
         wb_float densityOffset;
         
         Vec3 center;
@@ -37,24 +41,41 @@ namespace WorldBuilder {
         wb_float maxEdgeAngle;
         
         uint32_t id; // id in the world plate map
+        
+        void set_orientation(const Quaternion& ourOrientation);
     public:
         // TODO, make not public!
-        std::unordered_map<uint32_t, std::shared_ptr<PlateCell>> cells;
-        std::unordered_map<uint32_t, std::shared_ptr<PlateCell>> edgeCells;
+        PlateCellStore cells;
+        std::vector<uint32_t> edgeCells; // grid indices of cells with edgeInfo in slot order, kept by World::updatePlateEdges
         std::unordered_set<uint32_t> riftingTargets;
         
-        Plate(uint32_t initialCellCount, uint32_t ourId);
+        Plate(uint32_t gridSize, uint32_t ourId);
         
-        void updateCellRadii(); // radius from plate pole, used for momentum tracking
+        // edge cells are exactly the cells carrying edgeInfo
+        bool isEdgeCell(uint32_t index) const {
+            const PlateCell* cell = this->cells.find(index);
+            return cell != nullptr && cell->edgeInfo != nullptr;
+        }
+        
+        // Angular momentum is sum m r^2 w over the cells, r the distance from the axis and w the angular speed
+        // momentum of the whole plate turning about axis at its current speed
+        wb_float momentumAbout(const Vec3& axis) const {
+            return cells.get_inertia().about(axis) * angularSpeed;
+        }
+        // angular momentum of one cell about the plate's pole
+        wb_float cellMomentum(const PlateCell& cell) const;
         
         size_t surfaceSize() const; // number of surface cells, not threadsafe
-        void move(wb_float timestep); // updates rotation matrix
+        void move(wb_float timestep); // updates orientation
         void homeostasis(const WorldAttributes, wb_float timestep);
         
         // transforms as point in local coordinates to world coordinates
         Vec3 localToWorld(Vec3 local){
             return math::affineRotaionMulVec(this->rotationMatrix, local);
         }
+        Vec3 worldToLocal(Vec3 world){
+            return math::affineRotaionMulVec(this->inverseRotation, world);
+        }
 
         
     }; // class Plate
@@ -8,6 +8,7 @@
 #ifndef PlateCell_hpp
 #define PlateCell_hpp
 
+#include <limits>
 #include <unordered_map>
 
 #include "RockColumn.hpp"
@@ -29,6 +30,24 @@ namespace WorldBuilder {
         uint32_t cellIndex;
         wb_float distance;
     };
+    /***************  Plate Cell Handle ***************/
+    /*  Refers to a cell of some plate by plate id and grid index
+     *  Unlike a pointer it stays meaningful while plates add, remove or move cells
+     */
+    struct PlateCellHandle {
+        static const uint32_t none = std::numeric_limits<uint32_t>::max();
+        
+        uint32_t plateId;
+        uint32_t cellIndex;
+        
+        PlateCellHandle() : plateId(none), cellIndex(none){};
+        PlateCellHandle(uint32_t plate, uint32_t cell) : plateId(plate), cellIndex(cell){};
+        
+        bool isValid() const {
+            return this->cellIndex != none;
+        }
+    };
+    
     class EdgeCellInfo {
     public:
         // EdgeNeighbor currently duplicates information held in the key
@@ -50,7 +69,7 @@ namespace WorldBuilder {
         //bool touched;
         //bool touchedNextRound;
         RockColumn displacedRock;
-        std::shared_ptr<PlateCell> deleteTarget;
+        PlateCellHandle deleteTarget;
         
         //DisplacementInfo() : touched(false), touchedNextRound(false){};
     };
@@ -60,18 +79,19 @@ namespace WorldBuilder {
      *  Used for tracking rock
      *  And effects between Plates
      *
-     *
+     *  Rock and base offset live in the owning PlateCellStore's arrays, the store binds them
+     *  Moving a cell moves everything else, the rock stays with whichever slot the store gives it
      */
     class PlateCell {
         friend class World;
         friend class Plate;
+        friend class PlateCellStore;
         friend class AngularMomentumTracker;
     private:
-        wb_float baseOffset;
+        wb_float* baseOffset;
         bool bIsSubducted;
-        wb_float poleRadius;
     public:
-        RockColumn rock;
+        RockColumnRef rock;
         const GridVertex* vertex;
         
         std::shared_ptr<EdgeCellInfo> edgeInfo; // shared with edge list
@@ -85,13 +105,12 @@ namespace WorldBuilder {
         
         
         PlateCell(const GridVertex* vertex);
-        
-        
-        // simple 
-        void homeostasis(const WorldAttributes, wb_float timestep);
+        PlateCell(const PlateCell&) = delete;
+        PlateCell(PlateCell&& other);
+        PlateCell& operator=(PlateCell&& other);
         
         wb_float get_elevation() const {
-            return this->baseOffset + this->rock.thickness();
+            return *this->baseOffset + this->rock.thickness();
         }
         
         const GridVertex* get_vertex() const {
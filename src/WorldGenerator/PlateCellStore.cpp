@@ -0,0 +1,187 @@
+// --
+//  PlateCellStore.cpp
+//  WorldGenerator
+//
+
+
+#include "PlateCellStore.hpp"
+
+#include <algorithm>
+
+namespace WorldBuilder {
+    const uint32_t PlateCellStore::noSlot;
+    
+    void PlateCellStore::bind(size_t slot) {
+        PlateCell& cell = this->cells[slot];
+        cell.rock.bind(this->layers, slot, this);
+        cell.baseOffset = &this->baseOffsets[slot];
+    }
+    
+    void PlateCellStore::massChanged(size_t slot, wb_float change) {
+        this->inertia.add(this->cells[slot].get_vertex()->get_vector(), change);
+    }
+    
+    // reserve every per slot array together, then point every cell back at its slot
+    void PlateCellStore::grow(size_t count) {
+        this->cells.reserve(count);
+        this->layers.reserve(count);
+        this->baseOffsets.reserve(count);
+        this->capacity = count;
+        for (size_t slot = 0; slot < this->cells.size(); slot++) {
+            this->bind(slot);
+        }
+    }
+    
+    PlateCell& PlateCellStore::insert(const GridVertex* vertex) {
+        uint32_t index = vertex->get_index();
+        if (this->slots[index] != noSlot) {
+            return this->cells[this->slots[index]];
+        }
+        if (this->cells.size() == this->capacity) {
+            this->grow(std::max<size_t>(16, 2*this->capacity));
+        }
+        uint32_t slot = this->cells.size();
+        this->slots[index] = slot;
+        this->changes.push_back(index);
+        this->positionSum = this->positionSum + vertex->get_vector();
+        this->cells.emplace_back(vertex);
+        this->layers.push_back(RockColumn());
+        this->baseOffsets.push_back(0);
+        this->bind(slot);
+        return this->cells.back();
+    }
+
+    PlateCell& PlateCellStore::insert(PlateCell&& cell) {
+        uint32_t index = cell.get_vertex()->get_index();
+        // the rock belongs to the store cell came from, read it out before anything moves
+        RockColumn rock = cell.rock;
+        wb_float baseOffset = *cell.baseOffset;
+        // logged even when replacing, the incoming cell brings its own edge info
+        this->changes.push_back(index);
+        if (this->slots[index] != noSlot) {
+            PlateCell& existing = this->cells[this->slots[index]];
+            existing = std::move(cell);
+            existing.rock = rock;
+            *existing.baseOffset = baseOffset;
+            return existing;
+        }
+        if (this->cells.size() == this->capacity) {
+            this->grow(std::max<size_t>(16, 2*this->capacity));
+        }
+        uint32_t slot = this->cells.size();
+        this->slots[index] = slot;
+        this->positionSum = this->positionSum + cell.get_vertex()->get_vector();
+        this->inertia.add(cell.get_vertex()->get_vector(), rock.mass());
+        this->cells.push_back(std::move(cell));
+        this->layers.push_back(rock);
+        this->baseOffsets.push_back(baseOffset);
+        this->bind(slot);
+        return this->cells.back();
+    }
+
+    void PlateCellStore::erase(uint32_t index) {
+        uint32_t slot = this->slots[index];
+        if (slot == noSlot) {
+            return;
+        }
+        this->changes.push_back(index);
+        this->positionSum = this->positionSum - this->cells[slot].get_vertex()->get_vector();
+        this->inertia.add(this->cells[slot].get_vertex()->get_vector(), -this->cells[slot].rock.mass());
+        uint32_t lastSlot = this->cells.size() - 1;
+        if (slot != lastSlot) {
+            this->cells[slot] = std::move(this->cells[lastSlot]);
+            this->layers.copySlot(lastSlot, slot);
+            this->baseOffsets[slot] = this->baseOffsets[lastSlot];
+            this->slots[this->cells[slot].get_vertex()->get_index()] = slot;
+        }
+        this->cells.pop_back();
+        this->layers.pop_back();
+        this->baseOffsets.pop_back();
+        this->slots[index] = noSlot;
+    }
+
+    void PlateCellStore::clear() {
+        for (auto&& cell : this->cells) {
+            this->slots[cell.get_vertex()->get_index()] = noSlot;
+            this->changes.push_back(cell.get_vertex()->get_index());
+        }
+        this->positionSum = Vec3();
+        this->inertia = InertiaTensor();
+        this->cells.clear();
+        this->layers.clear();
+        this->baseOffsets.clear();
+    }
+    
+    /*************** Batch Updates ***************/
+    // Same steps in the same order as the old per cell version, with the branches turned into selects
+    // so each loop vectorizes. Setters are skipped, validateLayers throws afterwards for anything that went bad
+    // Skipping the setters skips the rock views' mass reports too, so the changes are gathered and added here
+    void PlateCellStore::homeostasis(const WorldAttributes worldAttributes, wb_float timestep) {
+        size_t count = this->cells.size();
+        wb_float* sedT = this->layers.thickness[sedimentLayer].data();
+        wb_float* sedD = this->layers.density[sedimentLayer].data();
+        wb_float* conT = this->layers.thickness[continentalLayer].data();
+        wb_float* conD = this->layers.density[continentalLayer].data();
+        wb_float* ocnT = this->layers.thickness[oceanicLayer].data();
+        const wb_float* ocnD = this->layers.density[oceanicLayer].data();
+        wb_float* rootT = this->layers.thickness[rootLayer].data();
+        const wb_float* rootD = this->layers.density[rootLayer].data();
+        wb_float* offsets = this->baseOffsets.data();
+        std::vector<wb_float> massChanges(count);
+        
+        for (size_t i = 0; i < count; i++) {
+            wb_float startingMass = sedD[i]*sedT[i] + conD[i]*conT[i] + ocnD[i]*ocnT[i] + rootD[i]*rootT[i];
+            
+            // current water overhead, before modification
+            wb_float elevation = offsets[i] + (sedT[i] + conT[i] + ocnT[i] + rootT[i]);
+            wb_float waterMass = elevation < worldAttributes.sealevel ? (worldAttributes.sealevel - elevation) * 1000 : 0;
+            
+            // oceanic crust over 10km hardens back down to 9km, otherwise under thick continental crust it all hardens
+            // into root. Neither case leaves thicknessToHarden at 0, which adds nothing to the root
+            bool oceanicThick = ocnT[i] > 10000;
+            bool continentalThick = conT[i] > 10000;
+            wb_float oceanic = oceanicThick ? 9000 : (continentalThick ? 0 : ocnT[i]);
+            wb_float thicknessToHarden = ocnT[i] - oceanic;
+            ocnT[i] = oceanic;
+            wb_float root = rootT[i] + thicknessToHarden * ocnD[i] / rootD[i];
+            
+            // melt root thickness if too much
+            rootT[i] = root > 210000 ? 205000 : root;
+            
+            wb_float mass = sedD[i]*sedT[i] + conD[i]*conT[i] + ocnD[i]*ocnT[i] + rootD[i]*rootT[i];
+            offsets[i] = -1 * (mass + waterMass) / worldAttributes.mantleDensity;
+            
+            // harden any sediment over 3k meters into continental
+            bool hardens = sedT[i] > 3000;
+            wb_float sedimentToHarden = hardens ? (sedT[i] - 3000)*0.25*timestep : 0;
+            sedT[i] = sedT[i] - sedimentToHarden;
+            wb_float continental = conT[i] + sedimentToHarden;
+            wb_float combined = std::abs((conD[i]*conT[i] + sedD[i]*sedimentToHarden) / continental);
+            conD[i] = (hardens && continental > float_epsilon) ? combined : conD[i];
+            conT[i] = continental;
+            
+            massChanges[i] = sedD[i]*sedT[i] + conD[i]*conT[i] + ocnD[i]*ocnT[i] + rootD[i]*rootT[i] - startingMass;
+        }
+        validateLayers(this->layers);
+        
+        // hardening only moves mass between layers, mostly it's melting root that changes any
+        for (size_t i = 0; i < count; i++) {
+            if (massChanges[i] != 0) {
+                this->massChanged(i, massChanges[i]);
+            }
+        }
+        
+        // certain effects depend on cell age
+        for (auto&& cell : this->cells) {
+            cell.age += timestep;
+        }
+    }
+    
+    void PlateCellStore::elevations(wb_float* out) const {
+        columnThicknesses(this->layers, out);
+        size_t count = this->baseOffsets.size();
+        for (size_t i = 0; i < count; i++) {
+            out[i] += this->baseOffsets[i];
+        }
+    }
+}
@@ -0,0 +1,165 @@
+// --
+//  PlateCellStore.hpp
+//  WorldGenerator
+//
+//  Dense storage for the cells of a single plate
+//  Cells live contiguously in one array, a grid sized slot index answers "is vertex v in this plate" in constant time
+//
+//  A cell's grid vertex index is its handle, it stays valid through rifting, deletion of other cells and plate
+//  splitting. References and pointers into the store do not: insert may reallocate and erase moves the last cell
+//  into the hole, so hold on to grid indices across anything that adds or removes cells
+//
+//  Rock and base offsets are kept here struct of arrays, slot for slot with the cells, each cell's rock is a view into them
+//  The views report every write back to the store, so the inertia tensor follows the rock without rescanning it
+//
+//  Every insert and erase is logged by grid index until clearChanges, so edges can be updated around just those cells
+
+
+#ifndef PlateCellStore_hpp
+#define PlateCellStore_hpp
+
+#include <limits>
+#include <vector>
+
+#include "PlateCell.hpp"
+
+namespace WorldBuilder {
+    /***************  Inertia Tensor ***************/
+    /*  Mass weighted second moments of cells about the planet's center, cell positions are unit vectors
+     *  The moment of inertia about a unit axis a is mass - a.(sum m p p^T).a, the sum of m r^2 over the cells
+     *  for r the distance from the axis, so any pole is evaluated without visiting the cells
+     */
+    struct InertiaTensor {
+        wb_float mass;
+        wb_float xx, xy, xz, yy, yz, zz; // sum m p p^T, upper triangle
+        
+        InertiaTensor() : mass(0), xx(0), xy(0), xz(0), yy(0), yz(0), zz(0){};
+        
+        void add(const Vec3& position, wb_float cellMass) {
+            mass += cellMass;
+            xx += cellMass * position[0] * position[0];
+            xy += cellMass * position[0] * position[1];
+            xz += cellMass * position[0] * position[2];
+            yy += cellMass * position[1] * position[1];
+            yz += cellMass * position[1] * position[2];
+            zz += cellMass * position[2] * position[2];
+        }
+        wb_float about(const Vec3& axis) const {
+            wb_float aligned = axis[0] * axis[0] * xx + axis[1] * axis[1] * yy + axis[2] * axis[2] * zz +
+                               2 * (axis[0] * axis[1] * xy + axis[0] * axis[2] * xz + axis[1] * axis[2] * yz);
+            return mass - aligned;
+        }
+    };
+    
+    /***************  Plate Cell Store ***************/
+    /*  Contiguous PlateCells plus a grid index to slot lookup
+     *  Iterates in slot order, which is insertion order until something is erased
+     *
+     */
+    class PlateCellStore : private RockMassListener {
+    /*************** Member Variables ***************/
+    private:
+        std::vector<PlateCell> cells;
+        std::vector<uint32_t> slots; // grid index -> position in cells, noSlot if absent
+        RockLayers layers;
+        std::vector<wb_float> baseOffsets;
+        size_t capacity; // all per slot arrays are reserved to this, cells are rebound when it grows
+        std::vector<uint32_t> changes; // grid indices inserted, replaced or erased since clearChanges, may repeat
+        Vec3 positionSum; // sum of every cell's unit vector, kept as cells come and go
+        InertiaTensor inertia; // of every cell's rock, kept as cells come and go and as their rock is written
+        
+        void bind(size_t slot);
+        void grow(size_t count);
+        // writes through the cells' rock views land here, one plate's rock must not be written from two threads at once
+        void massChanged(size_t slot, wb_float change) override;
+
+    public:
+        static const uint32_t noSlot = std::numeric_limits<uint32_t>::max();
+
+        typedef std::vector<PlateCell>::iterator iterator;
+        typedef std::vector<PlateCell>::const_iterator const_iterator;
+
+        PlateCellStore(uint32_t gridSize) : slots(gridSize, noSlot), capacity(0){};
+        PlateCellStore(const PlateCellStore&) = delete;
+
+        // adds a cell for vertex, returns the existing cell if the vertex is already in the store
+        PlateCell& insert(const GridVertex* vertex);
+        // moves a cell in, replacing any cell already at its vertex
+        PlateCell& insert(PlateCell&& cell);
+        // removes the cell at index if present, the last cell takes its slot
+        void erase(uint32_t index);
+        void clear();
+        void reserve(size_t count) {
+            if (count > capacity) {
+                this->grow(count);
+            }
+        }
+        
+    /*************** Batch Updates ***************/
+        // PlateCell homeostasis for every cell at once, run down the layer arrays
+        void homeostasis(const WorldAttributes worldAttributes, wb_float timestep);
+        // elevation of every cell in slot order
+        void elevations(wb_float* out) const;
+
+    /*************** Lookup ***************/
+        bool contains(uint32_t index) const {
+            return slots[index] != noSlot;
+        }
+        // position of the cell in iteration order, noSlot if absent
+        uint32_t get_slot(uint32_t index) const {
+            return slots[index];
+        }
+        // nullptr if the vertex is not in the store
+        PlateCell* find(uint32_t index) {
+            uint32_t slot = slots[index];
+            return slot == noSlot ? nullptr : &cells[slot];
+        }
+        const PlateCell* find(uint32_t index) const {
+            uint32_t slot = slots[index];
+            return slot == noSlot ? nullptr : &cells[slot];
+        }
+
+    /*************** Getters ***************/
+        size_t size() const {
+            return cells.size();
+        }
+        bool empty() const {
+            return cells.empty();
+        }
+        uint32_t get_gridSize() const {
+            return slots.size();
+        }
+        const RockLayers& get_layers() const {
+            return layers;
+        }
+        const std::vector<uint32_t>& get_changes() const {
+            return changes;
+        }
+        Vec3 get_positionSum() const {
+            return positionSum;
+        }
+        const InertiaTensor& get_inertia() const {
+            return inertia;
+        }
+        
+    /*************** Setters ***************/
+        void clearChanges() {
+            changes.clear();
+        }
+
+        iterator begin() {
+            return cells.begin();
+        }
+        iterator end() {
+            return cells.end();
+        }
+        const_iterator begin() const {
+            return cells.begin();
+        }
+        const_iterator end() const {
+            return cells.end();
+        }
+    }; // class PlateCellStore
+} // namespace WorldBuilder
+
+#endif /* PlateCellStore_hpp */
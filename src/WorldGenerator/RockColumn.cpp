@@ -98,6 +98,167 @@ namespace WorldBuilder {
         return removedColumn;
     }
     
+    /*************** Rock Layers ***************/
+    void RockLayers::reserve(size_t count) {
+        for (int layer = 0; layer < rockLayerCount; layer++) {
+            this->thickness[layer].reserve(count);
+            this->density[layer].reserve(count);
+        }
+    }
+    
+    void RockLayers::push_back(const RockColumn& column) {
+        this->thickness[sedimentLayer].push_back(column.sediment.get_thickness());
+        this->density[sedimentLayer].push_back(column.sediment.get_density());
+        this->thickness[continentalLayer].push_back(column.continental.get_thickness());
+        this->density[continentalLayer].push_back(column.continental.get_density());
+        this->thickness[oceanicLayer].push_back(column.oceanic.get_thickness());
+        this->density[oceanicLayer].push_back(column.oceanic.get_density());
+        this->thickness[rootLayer].push_back(column.root.get_thickness());
+        this->density[rootLayer].push_back(column.root.get_density());
+    }
+    
+    void RockLayers::pop_back() {
+        for (int layer = 0; layer < rockLayerCount; layer++) {
+            this->thickness[layer].pop_back();
+            this->density[layer].pop_back();
+        }
+    }
+    
+    void RockLayers::clear() {
+        for (int layer = 0; layer < rockLayerCount; layer++) {
+            this->thickness[layer].clear();
+            this->density[layer].clear();
+        }
+    }
+    
+    void RockLayers::copySlot(size_t from, size_t to) {
+        for (int layer = 0; layer < rockLayerCount; layer++) {
+            this->thickness[layer][to] = this->thickness[layer][from];
+            this->density[layer][to] = this->density[layer][from];
+        }
+    }
+    
+    RockColumn RockLayers::get(size_t slot) const {
+        RockColumn column;
+        column.sediment = RockSegment(this->thickness[sedimentLayer][slot], this->density[sedimentLayer][slot]);
+        column.continental = RockSegment(this->thickness[continentalLayer][slot], this->density[continentalLayer][slot]);
+        column.oceanic = RockSegment(this->thickness[oceanicLayer][slot], this->density[oceanicLayer][slot]);
+        column.root = RockSegment(this->thickness[rootLayer][slot], this->density[rootLayer][slot]);
+        return column;
+    }
+    
+    void RockLayers::set(size_t slot, const RockColumn& column) {
+        this->thickness[sedimentLayer][slot] = column.sediment.get_thickness();
+        this->density[sedimentLayer][slot] = column.sediment.get_density();
+        this->thickness[continentalLayer][slot] = column.continental.get_thickness();
+        this->density[continentalLayer][slot] = column.continental.get_density();
+        this->thickness[oceanicLayer][slot] = column.oceanic.get_thickness();
+        this->density[oceanicLayer][slot] = column.oceanic.get_density();
+        this->thickness[rootLayer][slot] = column.root.get_thickness();
+        this->density[rootLayer][slot] = column.root.get_density();
+    }
+    
+    void columnMasses(const RockLayers& layers, wb_float* masses) {
+        size_t count = layers.size();
+        const wb_float* sedT = layers.thickness[sedimentLayer].data();
+        const wb_float* sedD = layers.density[sedimentLayer].data();
+        const wb_float* conT = layers.thickness[continentalLayer].data();
+        const wb_float* conD = layers.density[continentalLayer].data();
+        const wb_float* ocnT = layers.thickness[oceanicLayer].data();
+        const wb_float* ocnD = layers.density[oceanicLayer].data();
+        const wb_float* rootT = layers.thickness[rootLayer].data();
+        const wb_float* rootD = layers.density[rootLayer].data();
+        for (size_t i = 0; i < count; i++) {
+            masses[i] = sedD[i]*sedT[i] + conD[i]*conT[i] + ocnD[i]*ocnT[i] + rootD[i]*rootT[i];
+        }
+    }
+    
+    void columnThicknesses(const RockLayers& layers, wb_float* thicknesses) {
+        size_t count = layers.size();
+        const wb_float* sedT = layers.thickness[sedimentLayer].data();
+        const wb_float* conT = layers.thickness[continentalLayer].data();
+        const wb_float* ocnT = layers.thickness[oceanicLayer].data();
+        const wb_float* rootT = layers.thickness[rootLayer].data();
+        for (size_t i = 0; i < count; i++) {
+            thicknesses[i] = sedT[i] + conT[i] + ocnT[i] + rootT[i];
+        }
+    }
+    
+    RockColumn netColumn(const RockLayers& layers) {
+        RockColumn result;
+        RockSegment* segments[rockLayerCount] = {&result.sediment, &result.continental, &result.oceanic, &result.root};
+        size_t count = layers.size();
+        for (int layer = 0; layer < rockLayerCount; layer++) {
+            const wb_float* thickness = layers.thickness[layer].data();
+            const wb_float* density = layers.density[layer].data();
+            wb_float netThickness = 0;
+            wb_float netMass = 0;
+            for (size_t i = 0; i < count; i++) {
+                netThickness += thickness[i];
+                netMass += thickness[i]*density[i];
+            }
+            // same fallback as combineSegments, an empty layer keeps the starting density
+            if (netThickness > float_epsilon) {
+                *segments[layer] = RockSegment(netThickness, std::abs(netMass / netThickness));
+            } else {
+                *segments[layer] = RockSegment(netThickness, 1);
+            }
+        }
+        return result;
+    }
+    
+    void validateLayers(const RockLayers& layers) {
+        size_t count = layers.size();
+        for (int layer = 0; layer < rockLayerCount; layer++) {
+            const wb_float* thickness = layers.thickness[layer].data();
+            const wb_float* density = layers.density[layer].data();
+            // cheap vectorizable pass first, only walk the column again to find the culprit
+            bool valid = true;
+            for (size_t i = 0; i < count; i++) {
+                valid &= std::isfinite(thickness[i]) & (thickness[i] >= 0) & std::isnormal(density[i]) & (density[i] >= 0);
+            }
+            if (!valid) {
+                for (size_t i = 0; i < count; i++) {
+                    validateDensity(density[i]);
+                    validateThickness(thickness[i]);
+                }
+            }
+        }
+    }
+    
+    /*************** Rock References ***************/
+    RockColumn RockColumnRef::removeThickness(wb_float thickness) {
+        RockColumn column = *this;
+        RockColumn removed = column.removeThickness(thickness);
+        *this = column;
+        return removed;
+    }
+    
+    RockColumnRef::operator RockColumn() const {
+        RockColumn column;
+        column.sediment = this->sediment;
+        column.continental = this->continental;
+        column.oceanic = this->oceanic;
+        column.root = this->root;
+        return column;
+    }
+    
+    RockColumnRef& RockColumnRef::operator=(const RockColumn& column) {
+        this->sediment = column.sediment;
+        this->continental = column.continental;
+        this->oceanic = column.oceanic;
+        this->root = column.root;
+        return *this;
+    }
+    
+    RockColumnRef& RockColumnRef::operator=(const RockColumnRef& column) {
+        this->sediment = column.sediment;
+        this->continental = column.continental;
+        this->oceanic = column.oceanic;
+        this->root = column.root;
+        return *this;
+    }
+    
     void logColumnChange(RockColumn initial, RockColumn final, bool logSedCont, bool logNet){
         std::cout.precision(6);
         // log net rock vs change in thickness (both log fraction)
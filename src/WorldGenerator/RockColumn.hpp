@@ -4,6 +4,9 @@
 //
 //  Data structures representing a column of rock
 //  May describe: a section of the lithosphere, a section of rock being transfered between cells, net rock within a plate, ect
+//
+//  Columns belonging to plate cells are held struct of arrays in RockLayers, one thickness and one density array per layer,
+//  so whole plate kernels run straight down contiguous memory. RockColumnRef gives a single cell the same interface as a RockColumn
 
 #ifndef RockColumn_hpp
 #define RockColumn_hpp
@@ -11,9 +14,24 @@
 #include "Defines.h"
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 namespace WorldBuilder {
     
+    // throw unless the value is usable as a segment density or thickness
+    inline void validateDensity(wb_float density) {
+        if (!std::isnormal(density) || density < 0) {
+            std::cout << "Density of: " << density << std::endl;
+            throw std::invalid_argument("Non-normal density");
+        }
+    }
+    inline void validateThickness(wb_float thickness) {
+        if (!std::isfinite(thickness) || thickness < 0) {
+            std::cout << "Thickness of: " << thickness << std::endl;
+            throw std::invalid_argument("Invalid Thickness, must be >=0 and finite");
+        }
+    }
+    
     // A section of rock with specific properties based roughly on rock type (currently estimates of continental, oceanic crust, ect)
     class RockSegment {
         wb_float density;
@@ -28,17 +46,11 @@ namespace WorldBuilder {
         wb_float get_density() const {return density;};
         wb_float get_thickness() const {return thickness;};
         void set_density(wb_float newDensity){
-            if (!std::isnormal(newDensity) || newDensity < 0) {
-                std::cout << "Density of: " << newDensity << std::endl;
-                throw std::invalid_argument("Non-normal density");
-            }
+            validateDensity(newDensity);
             density = newDensity;
         }
         void set_thickness(wb_float newThickness){
-            if (!std::isfinite(newThickness) || newThickness < 0) {
-                std::cout << "Thickness of: " << newThickness << std::endl;
-                throw std::invalid_argument("Invalid Thickness, must be >=0 and finite");
-            }
+            validateThickness(newThickness);
             thickness = newThickness;
         }
         
@@ -79,6 +91,164 @@ namespace WorldBuilder {
     // combines rock columns, may want to be renamed to combineColumns
     RockColumn accreteColumns(RockColumn one, RockColumn two);
     
+    /*************** Rock Layers ***************/
+    enum RockLayer {
+        sedimentLayer = 0,
+        continentalLayer,
+        oceanicLayer,
+        rootLayer,
+        rockLayerCount
+    };
+    
+    // Many columns stored struct of arrays, slot n of every array belongs to column n
+    struct RockLayers {
+        std::vector<wb_float> thickness[rockLayerCount];
+        std::vector<wb_float> density[rockLayerCount];
+        
+        size_t size() const {
+            return thickness[0].size();
+        }
+        void reserve(size_t count);
+        void push_back(const RockColumn& column);
+        void pop_back();
+        void clear();
+        void copySlot(size_t from, size_t to);
+        
+        RockColumn get(size_t slot) const;
+        void set(size_t slot, const RockColumn& column);
+    };
+    
+    // batch kernels, same arithmetic as the single column versions
+    void columnMasses(const RockLayers& layers, wb_float* masses);
+    void columnThicknesses(const RockLayers& layers, wb_float* thicknesses);
+    // every column accreted together, summed per layer rather than one column at a time
+    RockColumn netColumn(const RockLayers& layers);
+    // batch kernels skip the per segment checks, this throws like the RockSegment setters if any segment went bad
+    void validateLayers(const RockLayers& layers);
+    
+    /*************** Rock References ***************/
+    // Told how much each write through a bound column changed its mass, so whatever owns the layers can keep
+    // sums over its columns current without rescanning them
+    class RockMassListener {
+    public:
+        virtual void massChanged(size_t slot, wb_float change) = 0;
+    protected:
+        ~RockMassListener(){};
+    };
+    
+    // where a bound column's segments report their writes, nowhere without a listener
+    struct RockMassHook {
+        RockMassListener* listener;
+        size_t slot;
+        
+        RockMassHook() : listener(nullptr), slot(0){};
+        
+        void changed(wb_float change) const {
+            if (listener != nullptr && change != 0) {
+                listener->massChanged(slot, change);
+            }
+        }
+    };
+    
+    // A segment living in RockLayers, same interface as RockSegment
+    // Bound and rebound by whatever owns the layers, copying one assigns the rock rather than the binding
+    class RockSegmentRef {
+        wb_float* density;
+        wb_float* thickness;
+        const RockMassHook* hook;
+        
+        void assign(wb_float newDensity, wb_float newThickness) {
+            wb_float oldMass = this->mass();
+            *density = newDensity;
+            *thickness = newThickness;
+            hook->changed(this->mass() - oldMass);
+        }
+        
+    public:
+        RockSegmentRef() : density(nullptr), thickness(nullptr), hook(nullptr){};
+        RockSegmentRef(const RockSegmentRef&) = delete;
+        
+        void bind(wb_float* densityPtr, wb_float* thicknessPtr, const RockMassHook* massHook) {
+            density = densityPtr;
+            thickness = thicknessPtr;
+            hook = massHook;
+        }
+        
+        wb_float get_density() const {return *density;};
+        wb_float get_thickness() const {return *thickness;};
+        void set_density(wb_float newDensity){
+            validateDensity(newDensity);
+            this->assign(newDensity, *thickness);
+        }
+        void set_thickness(wb_float newThickness){
+            validateThickness(newThickness);
+            this->assign(*density, newThickness);
+        }
+        
+        wb_float mass() const {
+            return (*density)*(*thickness);
+        }
+        
+        operator RockSegment() const {
+            return RockSegment(*thickness, *density);
+        }
+        RockSegmentRef& operator=(const RockSegment& segment) {
+            this->assign(segment.get_density(), segment.get_thickness());
+            return *this;
+        }
+        RockSegmentRef& operator=(const RockSegmentRef& segment) {
+            this->assign(segment.get_density(), segment.get_thickness());
+            return *this;
+        }
+    };
+    
+    // A column living in RockLayers, same interface as RockColumn
+    // Every write reports its change in mass to the listener it was bound with, if any
+    struct RockColumnRef {
+        RockSegmentRef sediment;
+        RockSegmentRef continental;
+        RockSegmentRef oceanic;
+        RockSegmentRef root;
+        
+    private:
+        RockMassHook hook;
+        
+    public:
+        RockColumnRef(){};
+        RockColumnRef(const RockColumnRef&) = delete;
+        
+        void bind(RockLayers& layers, size_t slot, RockMassListener* listener = nullptr) {
+            hook.listener = listener;
+            hook.slot = slot;
+            sediment.bind(&layers.density[sedimentLayer][slot], &layers.thickness[sedimentLayer][slot], &hook);
+            continental.bind(&layers.density[continentalLayer][slot], &layers.thickness[continentalLayer][slot], &hook);
+            oceanic.bind(&layers.density[oceanicLayer][slot], &layers.thickness[oceanicLayer][slot], &hook);
+            root.bind(&layers.density[rootLayer][slot], &layers.thickness[rootLayer][slot], &hook);
+        }
+        
+        wb_float mass() const{
+            return sediment.mass() + continental.mass() + oceanic.mass() + root.mass();
+        }
+        wb_float thickness() const {
+            return sediment.get_thickness() + continental.get_thickness() + oceanic.get_thickness() + root.get_thickness();
+        }
+        bool isEmpty() const{
+            return (this->thickness() < float_epsilon);
+        }
+        bool isContinental() const {
+            if (continental.get_thickness() > 1000){
+                return true;
+            }
+            return false;
+        }
+        
+        RockColumn removeThickness(wb_float thickness);
+        
+        operator RockColumn() const;
+        RockColumnRef& operator=(const RockColumn& column);
+        RockColumnRef& operator=(const RockColumnRef& column);
+    };
+    
     // Helper function for logging changes in rock columns
     void logColumnChange(RockColumn initial, RockColumn final, bool logSedCont, bool logNet);
 }
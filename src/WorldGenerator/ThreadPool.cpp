@@ -0,0 +1,207 @@
+// --
+//  ThreadPool.cpp
+//  WorldGenerator
+//
+
+
+#include "ThreadPool.hpp"
+
+namespace WorldBuilder {
+    // which pool and queue the current thread works for, workers only
+    static thread_local ThreadPool* currentPool = nullptr;
+    static thread_local uint32_t currentQueue = 0;
+
+    static std::mutex sharedPoolLock;
+    static std::shared_ptr<ThreadPool> sharedPool;
+
+    ThreadPool::ThreadPool(uint32_t threadCount) : queuedTasks(0), stopping(false) {
+        if (threadCount == 0) {
+            threadCount = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+        }
+        uint32_t workerCount = threadCount - 1;
+        for (uint32_t queueIndex = 0; queueIndex <= workerCount; queueIndex++) {
+            this->queues.emplace_back(new TaskQueue());
+        }
+        for (uint32_t workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+            this->workers.push_back(std::thread(&ThreadPool::workerLoop, this, workerIndex));
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        for (std::thread& worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()> task) {
+        // workers keep what they spawn local, everyone else goes through the shared queue
+        uint32_t queueIndex = currentPool == this ? currentQueue : this->workers.size();
+        {
+            std::lock_guard<std::mutex> guard(this->queues[queueIndex]->lock);
+            this->queues[queueIndex]->tasks.push_back(std::move(task));
+        }
+        {
+            // taken so a worker can't check queuedTasks and then miss the notify
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->queuedTasks++;
+        }
+        this->wake.notify_one();
+    }
+
+    bool ThreadPool::popTask(uint32_t queueIndex, bool newest, std::function<void()>& task) {
+        TaskQueue& queue = *this->queues[queueIndex];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        if (newest) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        this->queuedTasks--;
+        return true;
+    }
+
+    bool ThreadPool::runPendingTask() {
+        if (this->queuedTasks.load() == 0) {
+            return false;
+        }
+        uint32_t queueCount = this->queues.size();
+        uint32_t sharedQueue = queueCount - 1;
+        bool isWorker = currentPool == this;
+        uint32_t home = isWorker ? currentQueue : sharedQueue;
+
+        std::function<void()> task;
+        // own work newest first, keeps a worker in cache on what it just split
+        bool found = isWorker && this->popTask(home, true, task);
+        // then oldest from the shared queue and everyone else, oldest tasks are the largest
+        for (uint32_t offset = 0; !found && offset < queueCount; offset++) {
+            uint32_t queueIndex = (home + 1 + offset) % queueCount;
+            if (queueIndex == home && isWorker) {
+                continue;
+            }
+            found = this->popTask(queueIndex, false, task);
+        }
+        if (!found) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    void ThreadPool::workerLoop(uint32_t workerIndex) {
+        currentPool = this;
+        currentQueue = workerIndex;
+        while (true) {
+            if (this->runPendingTask()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(this->sleepLock);
+            this->wake.wait(guard, [this]() {
+                return this->stopping || this->queuedTasks.load() > 0;
+            });
+            if (this->stopping) {
+                return;
+            }
+        }
+    }
+
+    std::shared_ptr<ThreadPool> ThreadPool::shared() {
+        std::lock_guard<std::mutex> guard(sharedPoolLock);
+        if (!sharedPool) {
+            sharedPool = std::make_shared<ThreadPool>(0);
+        }
+        return sharedPool;
+    }
+
+    void ThreadPool::set_shared(std::shared_ptr<ThreadPool> pool) {
+        std::lock_guard<std::mutex> guard(sharedPoolLock);
+        sharedPool = pool;
+    }
+
+    /*************** Task Group ***************/
+    TaskGroup::~TaskGroup() {
+        try {
+            this->wait();
+        } catch (...) {
+        }
+    }
+
+    void TaskGroup::execute(GroupTask& task) {
+        try {
+            task.work();
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(this->errorLock);
+            if (!this->error) {
+                this->error = std::current_exception();
+            }
+        }
+        // last touch of the group, wait may return and destroy it once the lock is released
+        std::lock_guard<std::mutex> guard(this->doneLock);
+        if (--this->outstanding == 0) {
+            this->done.notify_all();
+        }
+    }
+
+    void TaskGroup::run(std::function<void()> task) {
+        this->outstanding++;
+        std::shared_ptr<GroupTask> groupTask = std::make_shared<GroupTask>(std::move(task));
+        {
+            std::lock_guard<std::mutex> guard(this->pendingLock);
+            this->pending.push_back(groupTask);
+        }
+        // a pool of one has no workers, the waiter runs everything
+        if (this->pool.get_threadCount() > 1) {
+            // once claimed by the waiter the group may be gone, so only touch it after winning the claim
+            this->pool.submit([this, groupTask]() {
+                if (!groupTask->claimed.exchange(true)) {
+                    this->execute(*groupTask);
+                }
+            });
+        }
+    }
+
+    void TaskGroup::wait() {
+        while (true) {
+            // newest first, the task most likely still in cache
+            std::shared_ptr<GroupTask> task;
+            {
+                std::lock_guard<std::mutex> guard(this->pendingLock);
+                if (!this->pending.empty()) {
+                    task = std::move(this->pending.back());
+                    this->pending.pop_back();
+                }
+            }
+            if (!task) {
+                break;
+            }
+            if (!task->claimed.exchange(true)) {
+                this->execute(*task);
+            }
+        }
+        // everything left was started by a worker
+        {
+            std::unique_lock<std::mutex> guard(this->doneLock);
+            this->done.wait(guard, [this]() {
+                return this->outstanding.load() == 0;
+            });
+        }
+        std::exception_ptr thrown;
+        {
+            std::lock_guard<std::mutex> guard(this->errorLock);
+            thrown = this->error;
+            this->error = nullptr;
+        }
+        if (thrown) {
+            std::rethrow_exception(thrown);
+        }
+    }
+}
@@ -0,0 +1,152 @@
+// --
+//  ThreadPool.hpp
+//  WorldGenerator
+//
+//  Long lived work stealing pool shared by every parallel loop in the simulation and renderer
+//  Each worker keeps its own deque, runs its newest task first and steals the oldest task from others when idle.
+//  Threads outside the pool push to a shared queue. A thread waiting on a TaskGroup runs that group's tasks
+//  nobody has started yet, so tasks may start and wait on further groups without deadlocking the pool,
+//  then sleeps until the started ones finish. It never picks up another group's work, so sessions sharing
+//  the pool don't wait on each other's tasks
+
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WorldBuilder {
+    /***************  Thread Pool ***************/
+    /*  Fixed set of workers, created once and kept until the pool is destroyed
+     *  threadCount counts the thread that waits on the work, so a pool of n runs n - 1 workers
+     *  and 1 runs everything inline on the waiting thread
+     */
+    class ThreadPool {
+    private:
+        struct TaskQueue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<TaskQueue>> queues; // one per worker, shared queue for outside threads last
+        std::vector<std::thread> workers;
+
+        std::mutex sleepLock;
+        std::condition_variable wake;
+        std::atomic<uint32_t> queuedTasks;
+        bool stopping;
+
+        void workerLoop(uint32_t workerIndex);
+        bool popTask(uint32_t queueIndex, bool newest, std::function<void()>& task);
+
+    public:
+        // 0 for one thread per hardware thread
+        ThreadPool(uint32_t threadCount);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // queue a task, prefer a TaskGroup so something waits on it
+        void submit(std::function<void()> task);
+        // run one queued task on the calling thread, own queue first then steal, false if nothing was queued
+        bool runPendingTask();
+
+        // work(begin, end) over consecutive chunks of at most grainSize covering [0, count), returns once all have run
+        // chunk boundaries depend only on count and grainSize, so per chunk results can be merged in a fixed order
+        template <typename Function>
+        void parallelFor(size_t count, size_t grainSize, Function work);
+
+    /*************** Getters ***************/
+        uint32_t get_threadCount() const {
+            return workers.size() + 1;
+        }
+        // grain that splits count into one chunk per thread
+        size_t evenGrain(size_t count) const {
+            size_t threads = this->get_threadCount();
+            return count < threads ? 1 : (count + threads - 1) / threads;
+        }
+
+    /*************** Process Wide Pool ***************/
+        // used wherever no pool was handed in, one thread per hardware thread unless replaced
+        static std::shared_ptr<ThreadPool> shared();
+        static void set_shared(std::shared_ptr<ThreadPool> pool);
+    }; // class ThreadPool
+
+    /***************  Task Group ***************/
+    /*  Tasks submitted together and waited on together
+     *  The first exception thrown by a task is rethrown from wait, the rest are dropped
+     *  Each task is queued both on the pool and with the group, whichever reaches it first runs it
+     */
+    class TaskGroup {
+    private:
+        struct GroupTask {
+            std::function<void()> work;
+            std::atomic<bool> claimed;
+            
+            GroupTask(std::function<void()> ourWork) : work(std::move(ourWork)), claimed(false){};
+        };
+        
+        ThreadPool& pool;
+        std::atomic<uint32_t> outstanding;
+        std::mutex errorLock;
+        std::exception_ptr error;
+        std::mutex pendingLock;
+        std::vector<std::shared_ptr<GroupTask>> pending; // not yet claimed by the waiter, may hold tasks the pool already ran
+        std::mutex doneLock;
+        std::condition_variable done; // signalled when outstanding reaches zero
+        
+        void execute(GroupTask& task);
+
+    public:
+        TaskGroup(ThreadPool& ourPool) : pool(ourPool), outstanding(0), error(nullptr){};
+        TaskGroup(const TaskGroup&) = delete;
+        // waits but swallows any exception, call wait to see them
+        ~TaskGroup();
+
+        void run(std::function<void()> task);
+        // runs queued tasks until every task in the group has finished
+        void wait();
+    }; // class TaskGroup
+
+    template <typename Function>
+    void ThreadPool::parallelFor(size_t count, size_t grainSize, Function work) {
+        if (count == 0) {
+            return;
+        }
+        if (grainSize == 0) {
+            grainSize = 1;
+        }
+        if (count <= grainSize || this->workers.empty()) {
+            for (size_t begin = 0; begin < count; begin += grainSize) {
+                work(begin, std::min(count, begin + grainSize));
+            }
+            return;
+        }
+        TaskGroup group(*this);
+        for (size_t begin = grainSize; begin < count; begin += grainSize) {
+            size_t end = std::min(count, begin + grainSize);
+            group.run([&work, begin, end]() {
+                work(begin, end);
+            });
+        }
+        // first chunk on this thread
+        try {
+            work(0, grainSize);
+        } catch (...) {
+            group.wait();
+            throw;
+        }
+        group.wait();
+    }
+} // namespace WorldBuilder
+
+#endif /* ThreadPool_hpp */
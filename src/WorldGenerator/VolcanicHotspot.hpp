@@ -7,6 +7,7 @@
 #ifndef VolcanicHotspot_hpp
 #define VolcanicHotspot_hpp
 
+#include <memory>
 #include <unordered_map>
 
 #include "math.hpp"
@@ -22,10 +23,10 @@ public:
     Vec3 worldLocation;
     std::unordered_map<uint32_t, uint32_t> closestPlateCellIndex;
 
-    std::weak_ptr<PlateCell> lastCell;
+    uint32_t lastCellIndex; // grid index of the last cell in lastPlate
     std::weak_ptr<Plate> lastPlate;
 
-    VolcanicHotspot() : weight(0), normWeight(0){};
+    VolcanicHotspot() : weight(0), normWeight(0), lastCellIndex(0){};
     
 };
     
@@ -8,8 +8,9 @@
 
 #include <iostream>
 #include <limits>
-#include <thread>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
 namespace WorldBuilder {
     
@@ -77,6 +78,10 @@ namespace WorldBuilder {
         updateTask.movement.start();
         this->columnMovementPhase(timestep);
         updateTask.movement.end();
+        if (this->balanceMode == balanceSolve || this->balanceMode == balanceSolveValidate) {
+            DisplacementSolveResult solved = this->get_balanceResult();
+            std::cout << "Solved displacement of " << solved.unknowns << " cells in at most " << solved.iterations << " iterations and " << solved.reweights << " reweights, worst relative residual " << solved.residual << ", largest update left " << solved.initialLargestRow / (this->cellSmallAngle / 10) << " of the relaxation's threshold" << std::endl;
+        }
         final = this->netRock();
         // std::cout << "Rock change after movement:" << std::endl;
         // logColumnChange(initial, final, false, false);
@@ -114,13 +119,13 @@ namespace WorldBuilder {
         
         
         // move them cells around a bunch!
-        std::vector<std::thread> threads;
-        for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
-            threads.push_back(std::thread(&World::balanceInternalPlateForce, this, plateIt->second, timestep));
-        }
-        for (auto threadIt = threads.begin(); threadIt != threads.end(); threadIt++) {
-            threadIt->join();
+        {
+            std::lock_guard<std::mutex> guard(this->balanceResultLock);
+            this->balanceResult = DisplacementSolveResult();
         }
+        this->forEachPlate([this, timestep](std::shared_ptr<Plate> plate) {
+            this->balanceInternalPlateForce(plate, timestep);
+        });
         
     }
     
@@ -129,16 +134,26 @@ namespace WorldBuilder {
         // normalize plate grid
         this->renormalizeAllPlates();
         
-        // rifting
-        std::vector<std::pair<std::shared_ptr<Plate>, std::vector<std::shared_ptr<PlateCell>>>> cellsToAddToPlates;
+        // rifting, every plate is tested before any gets new cells, then each adds only to itself
+        std::vector<std::pair<std::shared_ptr<Plate>, std::vector<uint32_t>>> cellsToAddToPlates;
         for (auto&& plateIt : this->plates) {
-            cellsToAddToPlates.push_back(std::make_pair(plateIt.second, this->riftPlate(plateIt.second)));
+            cellsToAddToPlates.push_back(std::make_pair(plateIt.second, std::vector<uint32_t>()));
         }
-        for (auto&& pairIt : cellsToAddToPlates) {
-            for (auto&& cellAddIt : pairIt.second) {
-                pairIt.first->cells.insert({cellAddIt->get_vertex()->get_index(), cellAddIt});
+        this->threadPool->parallelFor(cellsToAddToPlates.size(), 1, [this, &cellsToAddToPlates](size_t begin, size_t end) {
+            for (size_t plateIndex = begin; plateIndex < end; plateIndex++) {
+                cellsToAddToPlates[plateIndex].second = this->riftPlate(cellsToAddToPlates[plateIndex].first);
             }
-        }
+        });
+        this->threadPool->parallelFor(cellsToAddToPlates.size(), 1, [this, &cellsToAddToPlates](size_t begin, size_t end) {
+            for (size_t plateIndex = begin; plateIndex < end; plateIndex++) {
+                std::shared_ptr<Plate>& plate = cellsToAddToPlates[plateIndex].first;
+                for (uint32_t riftIndex : cellsToAddToPlates[plateIndex].second) {
+                    // create oceanic and add to plate
+                    PlateCell& riftedCell = plate->cells.insert(&this->worldGrid->get_vertices()[riftIndex]);
+                    riftedCell.rock = this->divergentOceanicColumn;
+                }
+            }
+        });
         
         // update momentum
         this->momentumTracker->commitTransfer();
@@ -156,16 +171,21 @@ namespace WorldBuilder {
         
         // split in supercontinent if needed
         this->supercontinentCycle();
+        this->updatePlateTransforms();
         
-        // update edges
-        for (auto&& plateIt : this->plates) {
-            this->updatePlateEdges(plateIt.second);
-        }
+        // update edges, each plate reads only its own cells
+        this->forEachPlate([this](std::shared_ptr<Plate> plate) {
+            this->updatePlateEdges(plate);
+        });
+        this->updatePlateBroadphase();
         
-        // knit back together
-        for (auto&& plateIt : this->plates) {
-            this->knitPlates(plateIt.second);
-        }
+        // knit back together, each plate writes only its own edge info and reads the other plates' cells
+        this->forEachPlate([this](std::shared_ptr<Plate> plate) {
+            this->knitPlates(plate);
+        });
+        
+        // plates hold still and keep their cells until the next movement phase, so this serves the rest of the step
+        this->updateOccupancy();
         
         // float it!
         this->homeostasis(timestep);
@@ -201,32 +221,18 @@ namespace WorldBuilder {
 /****************************** Transistion ******************************/
     
     // adds new oceanic cells along plate boundaries where appropriate
-    std::vector<std::shared_ptr<PlateCell>> World::riftPlate(std::shared_ptr<Plate> plate) {
-        std::vector<std::shared_ptr<PlateCell>> cellsToAdd;
+    // returns the grid indices to add, so every plate is tested before any changes
+    std::vector<uint32_t> World::riftPlate(std::shared_ptr<Plate> plate) {
+        std::vector<uint32_t> cellsToAdd;
         
-        std::vector<std::shared_ptr<Plate>> interactablePlates;
-        for (auto&& plateIt : this->plates) {
-            std::shared_ptr<Plate>& testPlate = plateIt.second;
-            // ignore self
-            if (testPlate != plate) {
-                // test interacability between plates
-                Matrix3x3 targetToTest = math::matrixMul(math::transpose(testPlate->rotationMatrix), plate->rotationMatrix);
-                // if the plates max extent overlap, test edges
-                Vec3 testCenter = math::affineRotaionMulVec(targetToTest, plate->center);
-                wb_float testAngle = math::angleBetweenUnitVectors(testPlate->center, testCenter);
-                if (testAngle < plate->maxEdgeAngle + testPlate->maxEdgeAngle || std::isnan(testAngle)) {
-                    // some cells may interact, add to interactables
-                    interactablePlates.push_back(testPlate);
-                }
-            }
-        }
+        const std::vector<std::shared_ptr<Plate>>& interactablePlates = this->get_interactingPlates(*plate);
         
         // for each rifting target
         for(auto&& riftIndex : plate->riftingTargets) {
             bool cellFound = false;
             for (auto&& testPlate : interactablePlates) {
                 // test interacability between plates
-                Matrix3x3 targetToTest = math::matrixMul(math::transpose(testPlate->rotationMatrix), plate->rotationMatrix);
+                const Matrix3x3& targetToTest = this->plateTransform(*plate, *testPlate);
                 // if the plates max extent overlap, test edges
                 Vec3 riftInTest = math::affineRotaionMulVec(targetToTest, this->worldGrid->get_vertices()[riftIndex].get_vector());
                 wb_float testAngle = math::angleBetweenUnitVectors(testPlate->center, riftInTest);
@@ -240,8 +246,7 @@ namespace WorldBuilder {
                     uint32_t indexInTest = this->getNearestGridIndex(riftInTest, hint);
                     
                     // check in cells
-                    auto cellTestIt = testPlate->cells.find(indexInTest);
-                    if (cellTestIt != testPlate->cells.end()) {
+                    if (testPlate->cells.contains(indexInTest)) {
                         cellFound = true;
                     } else {
                         auto testRift = testPlate->riftingTargets.find(indexInTest);
@@ -249,8 +254,7 @@ namespace WorldBuilder {
                             cellFound = true;
                         } else {
                             // check all neighbors
-                            for(auto&& neighborIt : this->worldGrid->get_vertices()[indexInTest].get_neighbors()) {
-                                uint32_t neighborIndex = neighborIt->get_index();
+                            for(uint32_t neighborIndex : this->worldGrid->get_neighbors(indexInTest)) {
                                 // only need to check rifting targets, as the nearest index would have been in rifting at least otherwise
                                 auto testNeighborRift = testPlate->riftingTargets.find(neighborIndex);
                                 if (testNeighborRift != testPlate->riftingTargets.end()) {
@@ -266,177 +270,275 @@ namespace WorldBuilder {
                 }
             }
             if (!cellFound) {
-                // create oceanic and add to plate
-                std::shared_ptr<PlateCell> riftedCell = std::make_shared<PlateCell>(&this->worldGrid->get_vertices()[riftIndex]);
-                riftedCell->rock = this->divergentOceanicColumn;
-                
-                cellsToAdd.push_back(riftedCell);
+                cellsToAdd.push_back(riftIndex);
             }
         }
         return cellsToAdd;
     }
     
     // recalculates which plate cells are on the edge of the plate
-    // updates a plate's center estimate
+    // updates a plate's bounding cap
     // could be moved to the Plate class
     void World::updatePlateEdges(std::shared_ptr<Plate> plate) {
-        // clear the edgeCells
-        plate->edgeCells.clear();
-        plate->riftingTargets.clear();
+        // centroid of the plate, tells which side of its edges the plate is on
+        Vec3 center;
+        // a new or mostly rebuilt plate is cheaper to scan whole than cell by cell
+        if (this->edgeUpdateMode == edgeRebuild || 4 * plate->cells.get_changes().size() > plate->cells.size()) {
+            center = this->rebuildPlateEdges(*plate);
+        } else {
+            this->updateChangedPlateEdges(*plate);
+            if (this->edgeUpdateMode == edgeValidate) {
+                this->validatePlateEdges(*plate);
+            }
+            center = plate->cells.get_positionSum();
+        }
+        plate->cells.clearChanges();
+        
+        //std::cout << "Edge cell count of " << plate->edgeCells.size() << " for plate with " << plate->cells.size() << " cells." << std::endl;
+        
+        // smallest cap around the edge cells, which holds the whole plate when it holds the plate's centroid
+        // otherwise the plate wraps around the outside of its edges, so fall back to the edge farthest from the centroid
+        Vec3 centroid = math::normalize3Vector(center);
+        std::vector<Vec3> edgePositions;
+        edgePositions.reserve(plate->edgeCells.size());
+        for (uint32_t edgeIndex : plate->edgeCells) {
+            edgePositions.push_back(this->worldGrid->get_position(edgeIndex));
+        }
+        Vec3 capCenter;
+        wb_float capAngle;
+        if (math::minimalBoundingCap(edgePositions, capCenter, capAngle) && capCenter.dot(centroid) >= std::cos(capAngle) - 1e-9) {
+            plate->center = capCenter;
+            plate->maxEdgeAngle = capAngle;
+        } else if (!plate->edgeCells.empty()) {
+            plate->center = centroid;
+            plate->maxEdgeAngle = 0;
+            for (const Vec3& edgePosition : edgePositions) {
+                wb_float testDistance = math::angleBetweenUnitVectors(plate->center, edgePosition);
+                if (testDistance > plate->maxEdgeAngle || std::isnan(testDistance)) {
+                    plate->maxEdgeAngle = testDistance;
+                }
+            }
+        } else {
+            // no edges, the plate is either empty or the whole sphere
+            plate->center = centroid;
+            plate->maxEdgeAngle = 2 * math::piOverTwo;
+        }
+        // add a bit to the max edge angle to capture cells withing one breadth of the rifing targets
+        plate->maxEdgeAngle = plate->maxEdgeAngle + 2 * this->cellSmallAngle;
         
-        // TODO replace with a smallest bounding circle implementation
+        // find nearest index
+        uint32_t hint = 0;
+        if (plate->centerVertex != nullptr) {
+            hint = plate->centerVertex->get_index();
+        }
+        plate->centerVertex = &this->worldGrid->get_vertices()[this->getNearestGridIndex(plate->center, hint)];
+    }
+    
+    Vec3 World::rebuildPlateEdges(Plate& plate) {
+        // clear the edgeCells
+        plate.edgeCells.clear();
+        plate.riftingTargets.clear();
         
-        // find the center of the plate, hope it's close tot where the smallest bounding circle's would be
         Vec3 center;
-        for (auto&& cellIt : plate->cells) {
-            std::shared_ptr<PlateCell> cell = cellIt.second;
-            
-            
-            
-            Vec3 cellVec = cell->get_vertex()->get_vector();
+        for (auto&& cell : plate.cells) {
+            Vec3 cellVec = cell.get_vertex()->get_vector();
             center = center + cellVec;
             
             // determine edges
             bool isEdge = false;
-            for (auto&& neighborIt : cell->get_vertex()->get_neighbors()) {
-                uint32_t index = neighborIt->get_index();
-                
+            for (uint32_t index : cell.get_vertex()->get_neighbors()) {
                 // test if index is in plate
-                auto neighborCellIt = plate->cells.find(index);
-                if (neighborCellIt == plate->cells.end()) {
+                if (!plate.cells.contains(index)) {
                     isEdge = true;
                     // add to rifting targets, keep looping to get the remaining rifting targest
-                    plate->riftingTargets.insert(index);
+                    plate.riftingTargets.insert(index);
                 }
             }
             if (isEdge) {
                 // create our EdgeCellInfo if needed
-                if (cell->edgeInfo == nullptr) {
-                    cell->edgeInfo = std::make_shared<EdgeCellInfo>();
+                if (cell.edgeInfo == nullptr) {
+                    cell.edgeInfo = std::make_shared<EdgeCellInfo>();
                 } else {
                     // clear neighbors, they need to be updated when plates are knit
-                    cell->edgeInfo->otherPlateNeighbors.clear();
+                    cell.edgeInfo->otherPlateNeighbors.clear();
                 }
                 // add to the plate edge container
-                plate->edgeCells.insert({cell->get_vertex()->get_index(), cell});
+                plate.edgeCells.push_back(cell.get_vertex()->get_index());
             } else {
                 // delete edge data
-                cell->edgeInfo = nullptr;
+                cell.edgeInfo = nullptr;
+            }
+        }
+        return center;
+    }
+    
+    // a cell's edge and rifting status only depends on which of its neighbors are in the plate,
+    // so only the changed cells and their neighbors need another look
+    void World::updateChangedPlateEdges(Plate& plate) {
+        std::vector<uint32_t> affected;
+        for (uint32_t index : plate.cells.get_changes()) {
+            affected.push_back(index);
+            for (uint32_t neighborIndex : this->worldGrid->get_neighbors(index)) {
+                affected.push_back(neighborIndex);
+            }
+        }
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+        
+        // edges away from the changes stay edges, deleted edges were logged so they are dropped here
+        std::vector<uint32_t> edgeCells;
+        edgeCells.reserve(plate.edgeCells.size());
+        for (uint32_t edgeIndex : plate.edgeCells) {
+            if (!std::binary_search(affected.begin(), affected.end(), edgeIndex)) {
+                edgeCells.push_back(edgeIndex);
             }
         }
         
-        //std::cout << "Edge cell count of " << plate->edgeCells.size() << " for plate with " << plate->cells.size() << " cells." << std::endl;
+        for (uint32_t index : affected) {
+            PlateCell* cell = plate.cells.find(index);
+            if (cell == nullptr) {
+                // outside the plate, a rifting target while any neighbor is in it
+                bool bordersPlate = false;
+                for (uint32_t neighborIndex : this->worldGrid->get_neighbors(index)) {
+                    if (plate.cells.contains(neighborIndex)) {
+                        bordersPlate = true;
+                        break;
+                    }
+                }
+                if (bordersPlate) {
+                    plate.riftingTargets.insert(index);
+                } else {
+                    plate.riftingTargets.erase(index);
+                }
+                continue;
+            }
+            plate.riftingTargets.erase(index);
+            bool isEdge = false;
+            for (uint32_t neighborIndex : this->worldGrid->get_neighbors(index)) {
+                if (!plate.cells.contains(neighborIndex)) {
+                    isEdge = true;
+                    break;
+                }
+            }
+            if (isEdge) {
+                if (cell->edgeInfo == nullptr) {
+                    cell->edgeInfo = std::make_shared<EdgeCellInfo>();
+                }
+                edgeCells.push_back(index);
+            } else {
+                cell->edgeInfo = nullptr;
+            }
+        }
         
-        // add center to plate
-        plate->center = math::normalize3Vector(center);
+        // slot order, as a rebuild would list them
+        std::sort(edgeCells.begin(), edgeCells.end(), [&plate](uint32_t a, uint32_t b) {
+            return plate.cells.get_slot(a) < plate.cells.get_slot(b);
+        });
+        plate.edgeCells.swap(edgeCells);
         
-        // find nearest index
-        uint32_t hint = 0;
-        if (plate->centerVertex != nullptr) {
-            hint = plate->centerVertex->get_index();
+        // clear neighbors, they need to be updated when plates are knit
+        for (uint32_t edgeIndex : plate.edgeCells) {
+            plate.cells.find(edgeIndex)->edgeInfo->otherPlateNeighbors.clear();
         }
-        plate->centerVertex = &this->worldGrid->get_vertices()[this->getNearestGridIndex(plate->center, hint)];
-        
-        // find max distance
-        plate->maxEdgeAngle = 0; // reset max distance
-        for (auto&& edgeIt : plate->edgeCells) {
-            std::shared_ptr<PlateCell> edge = edgeIt.second;
-            wb_float testDistance = math::angleBetweenUnitVectors(plate->center, edge->get_vertex()->get_vector());
-            if (testDistance > plate->maxEdgeAngle || std::isnan(testDistance)) {
-                plate->maxEdgeAngle = testDistance;
+    }
+    
+    void World::validatePlateEdges(const Plate& plate) const {
+        std::vector<uint32_t> edgeCells;
+        std::unordered_set<uint32_t> riftingTargets;
+        for (auto&& cell : plate.cells) {
+            bool isEdge = false;
+            for (uint32_t index : cell.get_vertex()->get_neighbors()) {
+                if (!plate.cells.contains(index)) {
+                    isEdge = true;
+                    riftingTargets.insert(index);
+                }
+            }
+            if (isEdge) {
+                edgeCells.push_back(cell.get_vertex()->get_index());
+            }
+            if (isEdge != (cell.edgeInfo != nullptr)) {
+                throw std::logic_error("Incremental edge update left stale edge info on a plate cell");
             }
         }
-        // add a bit to the max edge angle to capture cells withing one breadth of the rifing targets
-        plate->maxEdgeAngle = plate->maxEdgeAngle + 2 * this->cellSmallAngle;
+        if (edgeCells != plate.edgeCells) {
+            throw std::logic_error("Incremental edge update disagrees with a rebuild on the edge cells");
+        }
+        if (riftingTargets != plate.riftingTargets) {
+            throw std::logic_error("Incremental edge update disagrees with a rebuild on the rifting targets");
+        }
     }
     
     // knits the edges of plates together so the edge cells can interact
     void World::knitPlates(std::shared_ptr<Plate> plate) {
+        // plates knit in parallel, one scratch per thread kept between steps
+        static thread_local GridRingScratch knitRingScratch;
         wb_float knitDistance = 2.0 * this->cellSmallAngle;
 
         // logging vars
         uint32_t offEdgeCount = 0;
         uint32_t connections = 0;
         
-        for (auto&& plateIt : this->plates) {
-            std::shared_ptr<Plate> testPlate = plateIt.second;
-            // ignore self
-            if (testPlate != plate) {
-                // test interacability between plates
-                Matrix3x3 targetToTest = math::matrixMul(math::transpose(testPlate->rotationMatrix), plate->rotationMatrix);
-                // if the plates max extent overlap, test edges
-                Vec3 testCenter = math::affineRotaionMulVec(targetToTest, plate->center);
-                wb_float testAngle = math::angleBetweenUnitVectors(testPlate->center, testCenter);
-                // add buffer zone for plates that just barely are close enough
-                if (testAngle < plate->maxEdgeAngle + testPlate->maxEdgeAngle + this->cellSmallAngle*3 || std::isnan(testAngle)) {
-                    // some cells may interact
-                    for (auto&& edgeIt : plate->edgeCells) {
-                        std::shared_ptr<PlateCell> edgeCell = edgeIt.second;
-                        Vec3 targetEdgeInTest = math::affineRotaionMulVec(targetToTest, edgeCell->get_vertex()->get_vector());
-                        wb_float angleToCenter = math::angleBetweenUnitVectors(testPlate->center, targetEdgeInTest);
-                        if (angleToCenter < testPlate->maxEdgeAngle || std::isnan(angleToCenter)) {
-                            // edge cell may be close enough to interact
-                            uint32_t lastNearestForPlate = 0;
-                            auto lastNearestIt = edgeCell->edgeInfo->otherPlateLastNearest.find(testPlate->id);
-                            if (lastNearestIt != edgeCell->edgeInfo->otherPlateLastNearest.end()) {
-                                // set hint to last known
-                                lastNearestForPlate = lastNearestIt->second;
-                            }
-                            
-                            uint32_t nearestGridIndex = getNearestGridIndex(targetEdgeInTest, lastNearestForPlate);
-                            // set our last nearest, even if it isn't an edge
-                            edgeCell->edgeInfo->otherPlateLastNearest[testPlate->id] = nearestGridIndex;
-                            
-                            // check if it is an edge, and neighbors
-                            auto testEdgeIt = testPlate->edgeCells.find(nearestGridIndex);
-                            if (testEdgeIt != testPlate->edgeCells.end()) {
-                                std::shared_ptr<PlateCell> testEdge = testEdgeIt->second;
-                                uint64_t neighborKey;
-                                neighborKey = ((uint64_t)testPlate->id << 32) + nearestGridIndex;
-                                wb_float neighborDistance = math::distanceBetween3Points(targetEdgeInTest, testEdge->get_vertex()->get_vector());
-                                EdgeNeighbor edgeData;
-                                edgeData.plateIndex = testPlate->id;
-                                edgeData.cellIndex = nearestGridIndex;
-                                edgeData.distance = neighborDistance;
-                                edgeCell->edgeInfo->otherPlateNeighbors[neighborKey] = edgeData; //neighborDistance;
+        for (auto&& testPlate : this->get_interactingPlates(*plate)) {
+            // caps overlap, some cells may interact
+            const Matrix3x3& targetToTest = this->plateTransform(*plate, *testPlate);
+            for (uint32_t edgeIndex : plate->edgeCells) {
+                PlateCell& edgeCell = *plate->cells.find(edgeIndex);
+                Vec3 targetEdgeInTest = math::affineRotaionMulVec(targetToTest, edgeCell.get_vertex()->get_vector());
+                wb_float angleToCenter = math::angleBetweenUnitVectors(testPlate->center, targetEdgeInTest);
+                if (angleToCenter < testPlate->maxEdgeAngle || std::isnan(angleToCenter)) {
+                    // edge cell may be close enough to interact
+                    uint32_t lastNearestForPlate = 0;
+                    auto lastNearestIt = edgeCell.edgeInfo->otherPlateLastNearest.find(testPlate->id);
+                    if (lastNearestIt != edgeCell.edgeInfo->otherPlateLastNearest.end()) {
+                        // set hint to last known
+                        lastNearestForPlate = lastNearestIt->second;
+                    }
+                    
+                    uint32_t nearestGridIndex = getNearestGridIndex(targetEdgeInTest, lastNearestForPlate);
+                    // set our last nearest, even if it isn't an edge
+                    edgeCell.edgeInfo->otherPlateLastNearest[testPlate->id] = nearestGridIndex;
+                    
+                    // check if it is an edge, and neighbors
+                    if (testPlate->isEdgeCell(nearestGridIndex)) {
+                        uint64_t neighborKey;
+                        neighborKey = ((uint64_t)testPlate->id << 32) + nearestGridIndex;
+                        wb_float neighborDistance = math::distanceBetween3Points(targetEdgeInTest, this->worldGrid->get_position(nearestGridIndex));
+                        EdgeNeighbor edgeData;
+                        edgeData.plateIndex = testPlate->id;
+                        edgeData.cellIndex = nearestGridIndex;
+                        edgeData.distance = neighborDistance;
+                        edgeCell.edgeInfo->otherPlateNeighbors[neighborKey] = edgeData; //neighborDistance;
 
-                                connections++;
+                        connections++;
+                    }
+                    
+                    // loop over neighbors, three rings out
+                    for (uint32_t index : this->worldGrid->get_ring(nearestGridIndex, 3, knitRingScratch)) {
+                        if (testPlate->isEdgeCell(index)) {
+                            // check distance
+                            wb_float neighborDistance = math::distanceBetween3Points(targetEdgeInTest, this->worldGrid->get_position(index));
+                            if (neighborDistance > knitDistance) {
+                                continue;
                             }
-                            
-                            // loop over neighbors
-                            for (auto neighborIt : this->worldGrid->get_vertices()[nearestGridIndex].neighborsByDepth(3)) {
-                                uint32_t index = neighborIt.second->get_index();
-                                testEdgeIt = testPlate->edgeCells.find(index);
-                                if (testEdgeIt != testPlate->edgeCells.end()) {
-                                    std::shared_ptr<PlateCell> testEdge = testEdgeIt->second;
-                                    // check distance
-                                    wb_float neighborDistance = math::distanceBetween3Points(targetEdgeInTest, testEdge->get_vertex()->get_vector());
-                                    if (neighborDistance > knitDistance) {
-                                        continue;
-                                    }
-                                    // add edge
-                                    uint64_t neighborKey;
-                                    neighborKey = ((uint64_t)testPlate->id << 32) + index;
-                                    EdgeNeighbor edgeData;
-                                    edgeData.plateIndex = testPlate->id;
-                                    edgeData.cellIndex = index;
-                                    edgeData.distance = neighborDistance;
-                                    edgeCell->edgeInfo->otherPlateNeighbors[neighborKey] = edgeData;
+                            // add edge
+                            uint64_t neighborKey;
+                            neighborKey = ((uint64_t)testPlate->id << 32) + index;
+                            EdgeNeighbor edgeData;
+                            edgeData.plateIndex = testPlate->id;
+                            edgeData.cellIndex = index;
+                            edgeData.distance = neighborDistance;
+                            edgeCell.edgeInfo->otherPlateNeighbors[neighborKey] = edgeData;
 
-                                    connections++;
-                                }
-                            }
+                            connections++;
                         }
                     }
                 }
             }
         }
         // calculate off edge cells
-        for (auto&& edgeIt : plate->edgeCells) {
-            std::shared_ptr<PlateCell> edgeCell = edgeIt.second;
-            for (auto& neighborIt : this->worldGrid->get_vertices()[edgeCell->vertex->get_index()].get_neighbors()) {
-                auto testEdgeIt = plate->cells.find(neighborIt->get_index());
-                if (testEdgeIt == plate->cells.end()) {
+        for (uint32_t edgeIndex : plate->edgeCells) {
+            for (uint32_t neighborIndex : this->worldGrid->get_neighbors(edgeIndex)) {
+                if (!plate->cells.contains(neighborIndex)) {
                     offEdgeCount++;
                 }
             }
@@ -448,34 +550,42 @@ namespace WorldBuilder {
     
     // renormalize plates and transfer rock from cells that are too thin
     void World::renormalizeAllPlates() {
-        // renormalize all plates
-        for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
-            this->renormalizePlate(plateIt->second);
-        }
+        // renormalize all plates, each only touches its own cells
+        this->forEachPlate([this](std::shared_ptr<Plate> plate) {
+            this->renormalizePlate(plate);
+        });
         
         // move rock from destroyed cells to targets, rock will now be on the plate itself (no longer in the displacementinfo
         // currently assumed only edge cells could be deleted
         for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
             std::shared_ptr<Plate> plate = plateIt->second;
-            std::vector<std::shared_ptr<PlateCell>> cellsToDelete;
-            for (auto cellIt = plate->edgeCells.begin(); cellIt != plate->edgeCells.end(); cellIt++) {
-                std::shared_ptr<PlateCell> cell = cellIt->second;
-                if (cell->displacement != nullptr && cell->displacement->deleteTarget != nullptr) {
-                    cellsToDelete.push_back(cell);
+            std::vector<uint32_t> cellsToDelete;
+            for (uint32_t edgeIndex : plate->edgeCells) {
+                PlateCell& cell = *plate->cells.find(edgeIndex);
+                if (cell.displacement != nullptr && cell.displacement->deleteTarget.isValid()) {
+                    cellsToDelete.push_back(edgeIndex);
+                    // the target may already have been deleted by its own plate, its rock is dropped with it
+                    PlateCell* deleteTarget = nullptr;
+                    auto targetPlateIt = this->plates.find(cell.displacement->deleteTarget.plateId);
+                    if (targetPlateIt != this->plates.end()) {
+                        deleteTarget = targetPlateIt->second->cells.find(cell.displacement->deleteTarget.cellIndex);
+                    }
+                    if (deleteTarget == nullptr) {
+                        continue;
+                    }
                     // only move sediment if age is less than min
-                    if (cell->age < min_interaction_age) {
-                        cell->displacement->deleteTarget->rock.sediment = combineSegments(cell->displacement->deleteTarget->rock.sediment, cell->rock.sediment);
-                        cell->displacement->deleteTarget->rock.continental = combineSegments(cell->displacement->deleteTarget->rock.continental, cell->rock.continental);
+                    if (cell.age < min_interaction_age) {
+                        deleteTarget->rock.sediment = combineSegments(deleteTarget->rock.sediment, cell.rock.sediment);
+                        deleteTarget->rock.continental = combineSegments(deleteTarget->rock.continental, cell.rock.continental);
                     } else {
-                        cell->displacement->deleteTarget->rock = accreteColumns(cell->displacement->deleteTarget->rock, cell->rock);
+                        deleteTarget->rock = accreteColumns(deleteTarget->rock, cell.rock);
                     }
                 }
             }
             int deleteCount = 0;
-            for (auto deleteIt = cellsToDelete.begin(); deleteIt != cellsToDelete.end(); deleteIt++) {
-                (*deleteIt)->displacement = nullptr;
-                // skip erasing from edges, as that map gets cleared next
-                plate->cells.erase((*deleteIt)->get_vertex()->get_index());
+            for (uint32_t deleteIndex : cellsToDelete) {
+                // skip erasing from edges, updatePlateEdges drops it from the erase logged by the store
+                plate->cells.erase(deleteIndex);
                 
                 deleteCount++;
             }
@@ -485,99 +595,151 @@ namespace WorldBuilder {
         // clear displaced?
         for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
             std::shared_ptr<Plate> plate = plateIt->second;
-            for (auto cellIt = plate->cells.begin(); cellIt != plate->cells.end(); cellIt++) {
-                std::shared_ptr<PlateCell> cell = cellIt->second;
-                cell->displacement = nullptr;
+            for (auto&& cell : plate->cells) {
+                cell.displacement = nullptr;
             }
         }
     }
     
+    // part of a displaced cell's rock headed for one destination cell, both as slots in the plate's store
+    struct RockContribution {
+        uint32_t destination;
+        uint32_t source;
+        wb_float fraction;
+    };
+    
     // redistributes rock such that cells once again lay along the origional grid
     // could be moved to the Plate class
+    // Displaced cells find their destinations in parallel, then each destination accretes its contributions in the order
+    // the serial loop would have, so the result is the same for any thread count
     void World::renormalizePlate(std::shared_ptr<Plate> plate) {
         // if a cell has been moved, the rock needs to be copied to the displaced info section
-        for (auto cellIt = plate->cells.begin(); cellIt != plate->cells.end(); cellIt++) {
-            std::shared_ptr<PlateCell> cell = cellIt->second;
-            if (cell->displacement != nullptr) {
-                cell->displacement->displacedRock = cell->rock;
+        std::vector<uint32_t> displacedSlots;
+        uint32_t slot = 0;
+        for (auto&& cell : plate->cells) {
+            if (cell.displacement != nullptr) {
+                displacedSlots.push_back(slot);
+                cell.displacement->displacedRock = cell.rock;
                 RockSegment zeroSegment(0,1);
-                cell->rock.sediment = zeroSegment;
-                cell->rock.continental = zeroSegment;
-                cell->rock.oceanic = zeroSegment;
-                cell->rock.root = zeroSegment;
+                cell.rock.sediment = zeroSegment;
+                cell.rock.continental = zeroSegment;
+                cell.rock.oceanic = zeroSegment;
+                cell.rock.root = zeroSegment;
             }
+            slot++;
         }
         
-        // move rock from each displaced cell based on weighted overlap
-        std::vector<std::pair<std::shared_ptr<PlateCell>, wb_float>> weights;
-        wb_float totalWeight;
-        int totalDisplaced = 0;
-        for (auto cellIt = plate->cells.begin(); cellIt != plate->cells.end(); cellIt++) {
-            std::shared_ptr<PlateCell> cell = cellIt->second;
-            if (cell->displacement != nullptr) {
-                totalDisplaced++;
+        // gather, the weights of every cell each displaced cell overlaps, in displaced cell order
+        const size_t gatherGrain = 256;
+        std::vector<std::vector<RockContribution>> chunkContributions((displacedSlots.size() + gatherGrain - 1) / gatherGrain);
+        this->threadPool->parallelFor(displacedSlots.size(), gatherGrain, [&](size_t begin, size_t end) {
+            std::vector<RockContribution>& contributions = chunkContributions[begin / gatherGrain];
+            std::vector<uint32_t> targetSlots;
+            std::vector<wb_float> squareDistances;
+            std::vector<wb_float> weights;
+            for (size_t displaced = begin; displaced < end; displaced++) {
+                const PlateCell& cell = *(plate->cells.begin() + displacedSlots[displaced]);
                 // find the weights of each overlapping cell
-                weights.clear();
-                totalWeight = 0;
+                targetSlots.clear();
+                squareDistances.clear();
                 
                 // find the normalized new location
-                Vec3 cellLocation = math::normalize3Vector(cell->get_vertex()->get_vector() + cell->displacement->displacementLocation);
+                Vec3 cellLocation = math::normalize3Vector(cell.get_vertex()->get_vector() + cell.displacement->displacementLocation);
                 
                 // find the nearest index
-                uint32_t nearestIndex = this->getNearestGridIndex(cellLocation, cell->get_vertex()->get_index());
-                const GridVertex* nearestVertex = &this->worldGrid->get_vertices()[nearestIndex];
+                uint32_t nearestIndex = this->getNearestGridIndex(cellLocation, cell.get_vertex()->get_index());
+                GridNeighbors nearestNeighbors = this->worldGrid->get_neighbors(nearestIndex);
                 
                 // find weights for nearest and each neighbors
                 // can't trust the world cell size estimate until more uniform grid is created, but radius should be roughly the same for nearby cells
-                wb_float cellRadius = math::distanceBetween3Points(nearestVertex->get_vector(), nearestVertex->get_neighbors()[0]->get_vector()) / 2;
-                // check the nearest is in the plate
-                auto targetCellIt = plate->cells.find(nearestIndex);
-                if (targetCellIt != plate->cells.end()) {
-                    std::shared_ptr<PlateCell> targetCell = targetCellIt->second;
-                    // weight with nearest
-                    wb_float weight = math::circleIntersectionArea(math::distanceBetween3Points(targetCell->get_vertex()->get_vector(), cellLocation), cellRadius);
-                    totalWeight += weight;
-                    weights.push_back(std::make_pair(targetCell, weight));
-                }
-                // each neighbor
-                for (auto neighborIt = nearestVertex->get_neighbors().begin(); neighborIt != nearestVertex->get_neighbors().end(); neighborIt++) {
-                    targetCellIt = plate->cells.find((*neighborIt)->get_index());
-                    if (targetCellIt != plate->cells.end()) {
-                        std::shared_ptr<PlateCell> targetCell = targetCellIt->second;
-                        // weight with neighbor
-                        wb_float weight = math::circleIntersectionArea(math::distanceBetween3Points(targetCell->get_vertex()->get_vector(), cellLocation), cellRadius);
-                        totalWeight += weight;
-                        weights.push_back(std::make_pair(targetCell, weight));
+                wb_float cellRadius = this->worldGrid->get_cellRadius(nearestIndex);
+                // the nearest then each neighbor, if they are in the plate
+                uint32_t targetSlot = plate->cells.get_slot(nearestIndex);
+                if (targetSlot != PlateCellStore::noSlot) {
+                    targetSlots.push_back(targetSlot);
+                    squareDistances.push_back(math::squareDistanceBetween3Points(this->worldGrid->get_position(nearestIndex), cellLocation));
+                }
+                for (uint32_t neighborIndex : nearestNeighbors) {
+                    targetSlot = plate->cells.get_slot(neighborIndex);
+                    if (targetSlot != PlateCellStore::noSlot) {
+                        targetSlots.push_back(targetSlot);
+                        squareDistances.push_back(math::squareDistanceBetween3Points(this->worldGrid->get_position(neighborIndex), cellLocation));
                     }
                 }
+                weights.resize(targetSlots.size());
+                math::overlapWeightBatch(squareDistances.data(), squareDistances.size(), cellRadius, weights.data());
+                wb_float totalWeight = 0;
+                for (wb_float weight : weights) {
+                    totalWeight += weight;
+                }
                 
-                // move rock based on weights
                 if (totalWeight <= 0) {
                     throw std::logic_error("Cell moved to invalid location (likely outside of edge border).");
                 }
-                for (auto destinationIt = weights.begin(); destinationIt != weights.end(); destinationIt++) {
-                    std::shared_ptr<PlateCell> destinationCell = destinationIt->first;
-                    wb_float destinationWeight = destinationIt->second;
+                for (size_t target = 0; target < targetSlots.size(); target++) {
+                    contributions.push_back({targetSlots[target], displacedSlots[displaced], weights[target] / totalWeight});
+                }
+            }
+        });
+        std::vector<RockContribution> contributions;
+        for (auto&& chunk : chunkContributions) {
+            contributions.insert(contributions.end(), chunk.begin(), chunk.end());
+        }
+        
+        // bucket contributions by destination, stable so each bucket keeps gather order
+        std::vector<uint32_t> bucketStarts(plate->cells.size() + 1, 0);
+        for (const RockContribution& contribution : contributions) {
+            bucketStarts[contribution.destination + 1]++;
+        }
+        std::vector<uint32_t> destinations;
+        for (uint32_t destination = 0; destination < plate->cells.size(); destination++) {
+            if (bucketStarts[destination + 1] != 0) {
+                destinations.push_back(destination);
+            }
+            bucketStarts[destination + 1] += bucketStarts[destination];
+        }
+        std::vector<uint32_t> bucketed(contributions.size());
+        {
+            std::vector<uint32_t> bucketEnds(bucketStarts.begin(), bucketStarts.end() - 1);
+            for (uint32_t contribution = 0; contribution < contributions.size(); contribution++) {
+                bucketed[bucketEnds[contributions[contribution].destination]++] = contribution;
+            }
+        }
+        
+        // scatter, every destination on its own into a column of its own, the cells are written afterwards
+        // in destination order, as rock written through a cell is reported to the plate's inertia tensor
+        std::vector<RockColumn> accreted(destinations.size());
+        this->threadPool->parallelFor(destinations.size(), gatherGrain, [&](size_t begin, size_t end) {
+            for (size_t destinationIndex = begin; destinationIndex < end; destinationIndex++) {
+                uint32_t destination = destinations[destinationIndex];
+                RockColumn& destinationRock = accreted[destinationIndex];
+                destinationRock = (plate->cells.begin() + destination)->rock;
+                for (uint32_t entry = bucketStarts[destination]; entry < bucketStarts[destination + 1]; entry++) {
+                    const RockContribution& contribution = contributions[bucketed[entry]];
+                    const RockColumn& displacedRock = (plate->cells.begin() + contribution.source)->displacement->displacedRock;
                     RockColumn moveColumn;
                     // set densities
-                    moveColumn.sediment.set_density(cell->displacement->displacedRock.sediment.get_density());
-                    moveColumn.continental.set_density(cell->displacement->displacedRock.continental.get_density());
-                    moveColumn.oceanic.set_density(cell->displacement->displacedRock.oceanic.get_density());
-                    moveColumn.root.set_density(cell->displacement->displacedRock.root.get_density());
+                    moveColumn.sediment.set_density(displacedRock.sediment.get_density());
+                    moveColumn.continental.set_density(displacedRock.continental.get_density());
+                    moveColumn.oceanic.set_density(displacedRock.oceanic.get_density());
+                    moveColumn.root.set_density(displacedRock.root.get_density());
                     
                     // set thicknesses
-                    moveColumn.sediment.set_thickness(cell->displacement->displacedRock.sediment.get_thickness() * (destinationWeight / totalWeight));
-                    moveColumn.continental.set_thickness(cell->displacement->displacedRock.continental.get_thickness() * (destinationWeight / totalWeight));
-                    moveColumn.oceanic.set_thickness(cell->displacement->displacedRock.oceanic.get_thickness() * (destinationWeight / totalWeight));
-                    moveColumn.root.set_thickness(cell->displacement->displacedRock.root.get_thickness() * (destinationWeight / totalWeight));
+                    moveColumn.sediment.set_thickness(displacedRock.sediment.get_thickness() * contribution.fraction);
+                    moveColumn.continental.set_thickness(displacedRock.continental.get_thickness() * contribution.fraction);
+                    moveColumn.oceanic.set_thickness(displacedRock.oceanic.get_thickness() * contribution.fraction);
+                    moveColumn.root.set_thickness(displacedRock.root.get_thickness() * contribution.fraction);
                     
                     // combine with destination
-                    destinationCell->rock = accreteColumns(destinationCell->rock, moveColumn);
+                    destinationRock = accreteColumns(destinationRock, moveColumn);
                 }
             }
+        });
+        for (size_t destinationIndex = 0; destinationIndex < destinations.size(); destinationIndex++) {
+            (plate->cells.begin() + destinations[destinationIndex])->rock = accreted[destinationIndex];
         }
         
-        //std::cout << "Displaced " << totalDisplaced << " cells out of " << plate->cells.size() << std::endl;
+        //std::cout << "Displaced " << displacedSlots.size() << " cells out of " << plate->cells.size() << std::endl;
     }
     
     /*************** Homeostasis ***************/
@@ -590,37 +752,32 @@ namespace WorldBuilder {
     }
 
     void World::updateSealevel() {
-        std::vector<std::shared_ptr<PlateCell>> cells;
+        std::vector<wb_float> elevations;
         // compute size
         unsigned long size = 0;
         for (auto&& plateIt : this->plates) {
             auto plate = plateIt.second;
             size += plate->cells.size();
         }
-        cells.reserve(size);
+        elevations.resize(size);
 
-        // add cells to vector
+        // fill with every plate's elevations
+        size_t offset = 0;
         for (auto&& plateIt : this->plates) {
             auto plate = plateIt.second;
-            for (auto&& cellIt : plate->cells) {
-                cells.push_back(cellIt.second);
-            }
+            plate->cells.elevations(elevations.data() + offset);
+            offset += plate->cells.size();
         }
 
         // sort the thing
-        std::sort(cells.begin(), cells.end(), 
-            [](const std::shared_ptr<PlateCell> a, const std::shared_ptr<PlateCell> b) -> bool
-        {
-            return a->get_elevation() < b->get_elevation();
-        });
+        std::sort(elevations.begin(), elevations.end());
 
         // loop through until we've used up all the water
         wb_float currentWater = 0;
-        wb_float currentElevation = cells[0]->get_elevation();
+        wb_float currentElevation = elevations[0];
         //std::cout << "Starting fill elevation: " << currentElevation << std::endl;
         unsigned long seaCells = 0;
-        for (auto&& cell : cells) {
-            wb_float nextElevation = cell->get_elevation();
+        for (auto&& nextElevation : elevations) {
             wb_float nextWater = currentWater + (seaCells * (nextElevation - currentElevation));
             if (nextWater > this->attributes.totalSeaDepth) {
                 // compute exact level
@@ -647,17 +804,16 @@ namespace WorldBuilder {
         // loop through all plate cells
         for (auto&& plateIt : this->plates) {
             auto plate = plateIt.second;
-            for (auto&& cellIt : plate->cells) {
-                auto cell = cellIt.second;
-                wb_float latitude = std::abs(math::piOverTwo - math::angleBetweenUnitVectors(plate->localToWorld(cell->get_vertex()->get_vector()), northPole));
+            for (auto&& cell : plate->cells) {
+                wb_float latitude = std::abs(math::piOverTwo - math::angleBetweenUnitVectors(plate->localToWorld(cell.get_vertex()->get_vector()), northPole));
                 // TODO: handle nan lat
-                wb_float elevation = cell->get_elevation() - this->attributes.sealevel;
+                wb_float elevation = cell.get_elevation() - this->attributes.sealevel;
                 if (elevation < 0) {
                     elevation = 0;
                 }
                 // 25*(cos(2*latitude) + 0.4)
                 // lapse rate estimate of 5C/1000 meters above sealevel
-                cell->tempurature = 25*(std::cos(2*latitude) + 0.4) - 5 * elevation / 1000;
+                cell.tempurature = 25*(std::cos(2*latitude) + 0.4) - 5 * elevation / 1000;
             }
         }
         
@@ -670,9 +826,8 @@ namespace WorldBuilder {
         // loop through all plate cells
         for (auto&& plateIt : this->plates) {
             auto plate = plateIt.second;
-            for (auto&& cellIt : plate->cells) {
-                auto cell = cellIt.second;
-                wb_float latitude = std::abs(math::piOverTwo - math::angleBetweenUnitVectors(plate->localToWorld(cell->get_vertex()->get_vector()), northPole));
+            for (auto&& cell : plate->cells) {
+                wb_float latitude = std::abs(math::piOverTwo - math::angleBetweenUnitVectors(plate->localToWorld(cell.get_vertex()->get_vector()), northPole));
                 if (!std::isfinite(latitude)) {
                     // probably one of the poles
                     latitude = math::piOverTwo;
@@ -680,7 +835,7 @@ namespace WorldBuilder {
                 // e^(-(x)^2/(2 *0.6^2))/(sqrt(2*π) * 0.6) + 1/20*e^(-(x - 5/9*pi/2)^2/(2 * 0.1^2))/(sqrt(2*π) * 0.1)
                 // simplifies to 0.199471 e^(-50. (0.872665 - x)^2) + 0.664904 e^(-1.38889 x^2)
                 wb_float yearlyPrecip = 6.5*(0.199471 * std::exp(-50.0 * (0.872665 - latitude) * (0.872665 - latitude)) + 0.664904 * std::exp(-1.38889 * latitude * latitude));
-                cell->precipitation = yearlyPrecip * 1000000; // per million years
+                cell.precipitation = yearlyPrecip * 1000000; // per million years
             }
         }
     } // World::updatePrecipitation
@@ -742,11 +897,11 @@ namespace WorldBuilder {
     // could be moved to Plate class
     std::pair<std::shared_ptr<Plate>, std::shared_ptr<Plate>> World::splitPlate(std::shared_ptr<Plate> plateToSplit){
         std::pair<std::shared_ptr<Plate>, std::shared_ptr<Plate>> newPlates;
-        newPlates.first = std::make_shared<Plate>(0, this->nextPlateId()); // large
-        newPlates.second = std::make_shared<Plate>(0, this->nextPlateId()); // small
+        newPlates.first = std::make_shared<Plate>(this->worldGrid->verts_size(), this->nextPlateId()); // large
+        newPlates.second = std::make_shared<Plate>(this->worldGrid->verts_size(), this->nextPlateId()); // small
         
-        newPlates.first->rotationMatrix = plateToSplit->rotationMatrix;
-        newPlates.second->rotationMatrix = plateToSplit->rotationMatrix;
+        newPlates.first->set_orientation(plateToSplit->orientation);
+        newPlates.second->set_orientation(plateToSplit->orientation);
         
         // create poles and speeds
         newPlates.first->pole = this->randomSource->getRandomPointUnitSphere();
@@ -764,26 +919,24 @@ namespace WorldBuilder {
         
         // check distances
         float distanceSmall, distanceLarge1, distanceLarge2;
-        for (auto cellIt = plateToSplit->cells.begin(); cellIt != plateToSplit->cells.end(); cellIt++)
+        // the old plate is discarded after the split, so its cells are moved rather than copied
+        for (auto&& cell : plateToSplit->cells)
         {
-            std::shared_ptr<PlateCell> cell = cellIt->second;
-            uint32_t index = cellIt->first;
-            
-            distanceSmall = math::squareDistanceBetween3Points(smallCenter, cell->get_vertex()->get_vector());
+            distanceSmall = math::squareDistanceBetween3Points(smallCenter, cell.get_vertex()->get_vector());
             // could test distanceSmall in circle known to be closer
-            distanceLarge1 = math::squareDistanceBetween3Points(largeCenter1, cell->get_vertex()->get_vector());
+            distanceLarge1 = math::squareDistanceBetween3Points(largeCenter1, cell.get_vertex()->get_vector());
             if (distanceSmall > distanceLarge1) {
                 // copy rock, subduction
-                newPlates.first->cells[index] = cell;
+                newPlates.first->cells.insert(std::move(cell));
             } else {
-                distanceLarge2 = math::squareDistanceBetween3Points(largeCenter2, cell->get_vertex()->get_vector());
+                distanceLarge2 = math::squareDistanceBetween3Points(largeCenter2, cell.get_vertex()->get_vector());
                 if (distanceSmall > distanceLarge2) {
                     // copy rock, subduction
-                    newPlates.first->cells[index] = cell;
+                    newPlates.first->cells.insert(std::move(cell));
                 } else {
                     // closer to small
                     // copy rock, subduction
-                    newPlates.second->cells[index] = cell;
+                    newPlates.second->cells.insert(std::move(cell));
                 }
             }
         }
@@ -800,21 +953,18 @@ namespace WorldBuilder {
         }
         
         // get a random neighbor
-        const GridVertex* secondVertex = firstVertex->get_neighbors()[this->randomSource->randomUniform(0, firstVertex->get_neighbors().size() - 1)];
+        GridNeighbors firstNeighbors = firstVertex->get_neighbors();
+        uint32_t secondIndex = firstNeighbors[this->randomSource->randomUniform(0, firstNeighbors.size() - 1)];
         
         // find shared neighbors
-        std::vector<const GridVertex*> sharedNeighbors;
+        std::vector<uint32_t> sharedNeighbors;
         // TODO, could be opitmized to break inner once match found
-        for (std::vector<const GridVertex*>::const_iterator testOne = firstVertex->get_neighbors().begin();
-             testOne != firstVertex->get_neighbors().end();
-             testOne++)
+        for (uint32_t testOne : firstNeighbors)
         {
-            for (std::vector<const GridVertex*>::const_iterator testTwo = secondVertex->get_neighbors().begin();
-                 testTwo != secondVertex->get_neighbors().end();
-                 testTwo++)
+            for (uint32_t testTwo : this->worldGrid->get_neighbors(secondIndex))
             {
-                if (*testOne == *testTwo) {
-                    sharedNeighbors.push_back(*testOne);
+                if (testOne == testTwo) {
+                    sharedNeighbors.push_back(testOne);
                 }
             }
         }
@@ -824,32 +974,29 @@ namespace WorldBuilder {
             throw "no shared neighbors!!!!!";
         }
 #endif
-        const GridVertex* thirdVertex = sharedNeighbors[this->randomSource->randomUniform(0, sharedNeighbors.size() - 1)];
+        uint32_t thirdIndex = sharedNeighbors[this->randomSource->randomUniform(0, sharedNeighbors.size() - 1)];
         
-        return std::make_tuple(firstVertex->get_vector(), secondVertex->get_vector(), thirdVertex->get_vector());
+        return std::make_tuple(firstVertex->get_vector(), this->worldGrid->get_position(secondIndex), this->worldGrid->get_position(thirdIndex));
     }
     
     // for splitting only
     // should be renamed to reflect that oceanic cells can be returned if no continental available
     const GridVertex* World::getRandomContinentalVertex(std::shared_ptr<Plate> plateToSplit){
-        std::vector<std::shared_ptr<PlateCell>> continentalCells;
-        std::vector<std::shared_ptr<PlateCell>> oceanicCells;
-        for (auto plateCellIt = plateToSplit->cells.begin();
-             plateCellIt != plateToSplit->cells.end();
-             plateCellIt++)
+        std::vector<const GridVertex*> continentalCells;
+        std::vector<const GridVertex*> oceanicCells;
+        for (auto&& cell : plateToSplit->cells)
         {
-            std::shared_ptr<PlateCell> cell = plateCellIt->second;
-            if (cell->isContinental()) {
-                continentalCells.push_back(cell);
-            } else if (!cell->isSubducted() && !cell->rock.isEmpty()){
-                oceanicCells.push_back(cell);
+            if (cell.isContinental()) {
+                continentalCells.push_back(cell.get_vertex());
+            } else if (!cell.isSubducted() && !cell.rock.isEmpty()){
+                oceanicCells.push_back(cell.get_vertex());
             }
         }
         
         if (continentalCells.size() > 0) {
-            return continentalCells[this->randomSource->uniformIndex(0, continentalCells.size() - 1)]->get_vertex();
+            return continentalCells[this->randomSource->uniformIndex(0, continentalCells.size() - 1)];
         } else if (oceanicCells.size() > 0) {
-            return oceanicCells[this->randomSource->uniformIndex(0, oceanicCells.size() - 1)]->get_vertex();
+            return oceanicCells[this->randomSource->uniformIndex(0, oceanicCells.size() - 1)];
         } else {
             // plate has no cells?????
             return nullptr;
@@ -867,11 +1014,10 @@ namespace WorldBuilder {
         
         for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
             std::shared_ptr<Plate> plate = plateIt->second;
-            for (auto cellIt = plate->cells.begin(); cellIt != plate->cells.end(); cellIt++) {
-                std::shared_ptr<PlateCell> cell = cellIt->second;
+            for (auto&& cell : plate->cells) {
                 
                 // create sediement
-                wb_float activeElevation = cell->get_elevation();
+                wb_float activeElevation = cell.get_elevation();
                 wb_float elevationAboveSealevel = activeElevation - this->attributes.sealevel;
                 // move some stuff to lower elevation cells
                 wb_float erosionFactor = elevationAboveSealevel / (4000);
@@ -884,33 +1030,31 @@ namespace WorldBuilder {
                         erosionFactor = 0.5;
                     }
                     erosionHeight = erosionFactor * timestep * (activeElevation - this->attributes.sealevel);
-                    RockSegment erodedSegment = cell->erodeThickness(erosionHeight);
-                    cell->rock.sediment = combineSegments(cell->rock.sediment, erodedSegment);
+                    RockSegment erodedSegment = cell.erodeThickness(erosionHeight);
+                    cell.rock.sediment = combineSegments(cell.rock.sediment, erodedSegment);
                 }
                 
                 // caluclate neighbor count so we know what fraction to move to each
                 wb_float neighborCount = 0;
-                for (auto neighborIndexIt = cell->get_vertex()->get_neighbors().begin(); neighborIndexIt != cell->get_vertex()->get_neighbors().end(); neighborIndexIt++) {
-                    auto neighborIt = plate->cells.find((*neighborIndexIt)->get_index());
-                    if (neighborIt != plate->cells.end()) {
+                for (uint32_t neighborIndex : cell.get_vertex()->get_neighbors()) {
+                    if (plate->cells.contains(neighborIndex)) {
                         neighborCount++;
                     }
                 }
-                if (cell->edgeInfo != nullptr){
-                    neighborCount += cell->edgeInfo->otherPlateNeighbors.size();
+                if (cell.edgeInfo != nullptr){
+                    neighborCount += cell.edgeInfo->otherPlateNeighbors.size();
                 }
                 
                 // move to neighbors
-                for (auto neighborIndexIt = cell->get_vertex()->get_neighbors().begin(); neighborIndexIt != cell->get_vertex()->get_neighbors().end(); neighborIndexIt++) {
-                    auto neighborIt = plate->cells.find((*neighborIndexIt)->get_index());
-                    if (neighborIt != plate->cells.end()) {
-                        std::shared_ptr<PlateCell> neighborCell = neighborIt->second;
+                for (uint32_t neighborIndex : cell.get_vertex()->get_neighbors()) {
+                    PlateCell* neighborCell = plate->cells.find(neighborIndex);
+                    if (neighborCell != nullptr) {
                         wb_float neighborElevation = neighborCell->get_elevation();
                         if (activeElevation > neighborElevation) {
                             erosionHeight = (activeElevation - neighborElevation) * erosionRate(elevationAboveSealevel) * timestep / neighborCount;
                             
                             // erode from this cell
-                            RockSegment erodedSegment = cell->erodeThickness(erosionHeight);
+                            RockSegment erodedSegment = cell.erodeThickness(erosionHeight);
                             
                             // add to neighbor
                             neighborCell->rock.sediment = combineSegments(neighborCell->rock.sediment, erodedSegment);
@@ -918,20 +1062,19 @@ namespace WorldBuilder {
                     }
                 }
                 // and to edge neighbors
-                if (cell->edgeInfo != nullptr){
-                    for (auto neighborIndexIt = cell->edgeInfo->otherPlateNeighbors.begin(); neighborIndexIt != cell->edgeInfo->otherPlateNeighbors.end(); neighborIndexIt++) {
+                if (cell.edgeInfo != nullptr){
+                    for (auto neighborIndexIt = cell.edgeInfo->otherPlateNeighbors.begin(); neighborIndexIt != cell.edgeInfo->otherPlateNeighbors.end(); neighborIndexIt++) {
                         auto neighborPlateIt = this->plates.find(neighborIndexIt->second.plateIndex);
                         if (neighborPlateIt != this->plates.end()){
                             std::shared_ptr<Plate> neighborPlate = neighborPlateIt->second;
-                            auto neighborIt = neighborPlate->cells.find(neighborIndexIt->second.cellIndex);
-                            if (neighborIt != neighborPlate->cells.end()) {
-                                std::shared_ptr<PlateCell> neighborCell = neighborIt->second;
+                            PlateCell* neighborCell = neighborPlate->cells.find(neighborIndexIt->second.cellIndex);
+                            if (neighborCell != nullptr) {
                                 wb_float neighborElevation = neighborCell->get_elevation();
                                 if (activeElevation > neighborElevation) {
                                     erosionHeight = (activeElevation - neighborElevation) * erosionRate(elevationAboveSealevel) * timestep / neighborCount;
                                     
                                     // erode from this cell
-                                    RockSegment erodedSegment = cell->erodeThickness(erosionHeight);
+                                    RockSegment erodedSegment = cell.erodeThickness(erosionHeight);
                                     
                                     // add to neighbor
                                     neighborCell->rock.sediment = combineSegments(neighborCell->rock.sediment, erodedSegment);
@@ -971,10 +1114,9 @@ namespace WorldBuilder {
         // set initial elevations
         size_t nodeIndex = 0;
         for (auto&& plateIt : this->plates) {
-            for (auto&& cellIt : plateIt.second->cells) {
-                std::shared_ptr<PlateCell>& cell = cellIt.second;
-                graph->nodes[nodeIndex].set_source(cell);
-                cell->flowNode = &graph->nodes[nodeIndex];
+            for (auto&& cell : plateIt.second->cells) {
+                graph->nodes[nodeIndex].set_source(&cell);
+                cell.flowNode = &graph->nodes[nodeIndex];
                 nodeIndex++;
             }
         }
@@ -988,19 +1130,17 @@ namespace WorldBuilder {
         size_t edgeCellCount = 0;
         for (auto&& plateIt : this->plates) {
             std::shared_ptr<Plate>& plate = plateIt.second;
-            for (auto&& cellIt : plate->cells) {
-                std::shared_ptr<PlateCell>& cell = cellIt.second;
+            for (auto&& cell : plate->cells) {
                 // we grab the elevations from the flow graph, incase a different module wants to modify the elevatsion while sediment transport is in progress
-                wb_float elevation = cell->flowNode->elevation();
+                wb_float elevation = cell.flowNode->elevation();
                 
                 // find outflow candidates
                 wb_float largestHeightDifference = 0; // determines suspended material
                 bool hasOutflow = false;
                 // candidates from within the plate
-                for (auto&& neighborIndexIt : cell->get_vertex()->get_neighbors()) {
-                    auto neighborIt = plate->cells.find(neighborIndexIt->get_index());
-                    if (neighborIt != plate->cells.end()) {
-                        std::shared_ptr<PlateCell>& neighborCell = neighborIt->second;
+                for (uint32_t neighborIndex : cell.get_vertex()->get_neighbors()) {
+                    PlateCell* neighborCell = plate->cells.find(neighborIndex);
+                    if (neighborCell != nullptr) {
                         wb_float heightDifference = elevation - (neighborCell->flowNode->elevation());
                         if (heightDifference > float_epsilon) {
                             // downhill node found, take note
@@ -1010,20 +1150,19 @@ namespace WorldBuilder {
                             }
                             hasOutflow = true;
                         } else if (std::abs(heightDifference) <= float_epsilon) {
-                            cell->flowNode->equalNodes.insert(neighborCell->flowNode);
+                            cell.flowNode->equalNodes.insert(neighborCell->flowNode);
                         }
                     }
                 }
-                if (cell->edgeInfo != nullptr) {
+                if (cell.edgeInfo != nullptr) {
                     edgeCellCount++;
                     // we are an edge, check other plate neighbors
-                    for (auto&& neighborIndexIt : cell->edgeInfo->otherPlateNeighbors) {
+                    for (auto&& neighborIndexIt : cell.edgeInfo->otherPlateNeighbors) {
                         auto neighborPlateIt = this->plates.find(neighborIndexIt.second.plateIndex);
                         if (neighborPlateIt != this->plates.end()){
                             std::shared_ptr<Plate>& neighborPlate = neighborPlateIt->second;
-                            auto neighborIt = neighborPlate->cells.find(neighborIndexIt.second.cellIndex);
-                            if (neighborIt != neighborPlate->cells.end()) {
-                                std::shared_ptr<PlateCell>& neighborCell = neighborIt->second;
+                            PlateCell* neighborCell = neighborPlate->cells.find(neighborIndexIt.second.cellIndex);
+                            if (neighborCell != nullptr) {
                                 wb_float heightDifference = elevation - (neighborCell->flowNode->elevation());
                                 if (heightDifference > float_epsilon) {
                                     plateEdges++;
@@ -1034,7 +1173,7 @@ namespace WorldBuilder {
                                     }
                                     hasOutflow = true;
                                 } else if (std::abs(heightDifference) <= float_epsilon) {
-                                    cell->flowNode->equalNodes.insert(neighborCell->flowNode);
+                                    cell.flowNode->equalNodes.insert(neighborCell->flowNode);
                                 }
                             }
                         }
@@ -1052,19 +1191,19 @@ namespace WorldBuilder {
                         }
                         
                         // determine downhill slope
-                        cell->flowNode->downhillSlope = largestHeightDifference / this->cellDistanceMeters;
+                        cell.flowNode->downhillSlope = largestHeightDifference / this->cellDistanceMeters;
                         
                         //
                         for (auto&& candidateIt : outflowCandidates) {
                             if (candidateIt.first == nullptr) {
                                 throw "Null destination";
-                            } else if(candidateIt.first == cell->flowNode) {
+                            } else if(candidateIt.first == cell.flowNode) {
                                 throw "Source and cell are the same";
                             }
                             wb_float heightDifference = candidateIt.second;
                             std::shared_ptr<FlowEdge> edge = std::make_shared<FlowEdge>();
                             edge->destination = candidateIt.first;
-                            edge->source = cell->flowNode;
+                            edge->source = cell.flowNode;
                             edge->materialHeight = 0; // none moved yet
                             edge->weight = heightDifference*heightDifference / totalSquareElevationOut; // squared weighting on height
                             // add as outflow to this node
@@ -1080,19 +1219,19 @@ namespace WorldBuilder {
                         }
                         
                         // determine suspended sediment
-                        cell->flowNode->downhillSlope = largestHeightDifference / this->cellDistanceMeters;
+                        cell.flowNode->downhillSlope = largestHeightDifference / this->cellDistanceMeters;
                         
                         //
                         for (auto&& candidateIt : outflowCandidates) {
                             if (candidateIt.first == nullptr) {
                                 throw "Null destination";
-                            } else if(candidateIt.first == cell->flowNode) {
+                            } else if(candidateIt.first == cell.flowNode) {
                                 throw "Source and cell are the same";
                             }
                             wb_float heightDifference = candidateIt.second;
                             std::shared_ptr<FlowEdge> edge = std::make_shared<FlowEdge>();
                             edge->destination = candidateIt.first;
-                            edge->source = cell->flowNode;
+                            edge->source = cell.flowNode;
                             edge->materialHeight = 0; // none moved yet
                             edge->weight = heightDifference / totalElevationOut; // linear weighting on height
                             // add as outflow to this node
@@ -1153,10 +1292,10 @@ namespace WorldBuilder {
         // make sticky hotspot
         // TODO, make configurable
         bool validOutflow = false;
-        std::vector<std::shared_ptr<PlateCell>> validCells;
+        std::vector<PlateCell*> validCells;
         if (auto plate = hotspot->lastPlate.lock()) { 
-            if (auto cell = hotspot->lastCell.lock()) {
-                Vec3 locationInLocal = math::affineRotaionMulVec(math::transpose(plate->rotationMatrix), hotspot->worldLocation);
+            if (PlateCell* cell = plate->cells.find(hotspot->lastCellIndex)) {
+                Vec3 locationInLocal = plate->worldToLocal(hotspot->worldLocation);
                 wb_float dist = math::distanceBetween3Points(locationInLocal, plate->center) * this->attributes.radius;
                 // make config! (in km)
                 // TODO: handle nan distance
@@ -1167,13 +1306,19 @@ namespace WorldBuilder {
             }
         }
         
-        // find the relavent plate cell
+        // find the relavent plate cells, every plate over the hotspot gets a share
+        // only plates near the hotspot can have a cell there, without the occupancy try them all
         if (!validOutflow) {
+            std::vector<uint32_t> plateIds;
+            bool filtered = this->occupancyCurrent && this->nearbyPlates(this->worldGrid->nearestIndex(hotspot->worldLocation), plateIds);
             for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
                 std::shared_ptr<Plate> plate = plateIt->second;
+                if (filtered && std::find(plateIds.begin(), plateIds.end(), plate->id) == plateIds.end()) {
+                    continue;
+                }
                 
                 // check if we can interact
-                Vec3 locationInLocal = math::affineRotaionMulVec(math::transpose(plate->rotationMatrix), hotspot->worldLocation);
+                Vec3 locationInLocal = plate->worldToLocal(hotspot->worldLocation);
                 wb_float testAngle = math::angleBetweenUnitVectors(locationInLocal, plate->center);
                 if (plate->maxEdgeAngle == 0 || testAngle < plate->maxEdgeAngle || std::isnan(testAngle)) {
                     uint32_t hint = 0;
@@ -1186,12 +1331,12 @@ namespace WorldBuilder {
                     hotspot->closestPlateCellIndex[plate->id] = nearestIndex;
                     
                     // check if in plate
-                    auto nearestIt = plate->cells.find(nearestIndex);
-                    if (nearestIt != plate->cells.end()) {
-                        validCells.push_back(nearestIt->second);
+                    PlateCell* nearestCell = plate->cells.find(nearestIndex);
+                    if (nearestCell != nullptr) {
+                        validCells.push_back(nearestCell);
                         // TODO, make less hacky in setting last values for hotspot
                         hotspot->lastPlate = plate;
-                        hotspot->lastCell = nearestIt->second;
+                        hotspot->lastCellIndex = nearestIndex;
                     }
                 }
             }
@@ -1216,261 +1361,425 @@ namespace WorldBuilder {
     
     struct CellDeleteTarget {
         std::shared_ptr<Plate> plate;
-        std::shared_ptr<PlateCell> cell;
+        PlateCell* cell;
         
-        CellDeleteTarget(std::shared_ptr<Plate> initialPlate) : plate(initialPlate){};
+        CellDeleteTarget(std::shared_ptr<Plate> initialPlate) : plate(initialPlate), cell(nullptr){};
     };
     
 #warning "Do it!"
     // TODO make displacement always appear on an edge cell, so delete target is properly set
+    // Edge cells only write their own displacement, everything else is read, so plates and ranges of their edge cells
+    // run in parallel. Momentum goes to one buffer per range, merged in plate then edge order like the serial loop
     void World::computeEdgeInteraction(wb_float timestep){
-        // determine edge cell displacements, currently in the direction perpendicular to the closest triangle edge along the plate edge
-        std::unordered_map<uint32_t, Matrix3x3> testPlateTransforms;
+        const size_t edgeGrain = 128;
+        struct EdgeRange {
+            std::shared_ptr<Plate> plate;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<EdgeRange> ranges;
         for (auto&& plateIt : this->plates) {
             std::shared_ptr<Plate> plate = plateIt.second;
-            testPlateTransforms.clear();
-            for (auto&& edgeCellIt : plate->edgeCells) {
-                std::shared_ptr<PlateCell> edgeCell = edgeCellIt.second;
-                CellDeleteTarget deleteTarget(plate); // only plates less dense than this one
-                
-                for (auto&& lastNearestIt : edgeCell->edgeInfo->otherPlateLastNearest) {
-                    // check the plate exists
-                    auto testPlateIt = this->plates.find(lastNearestIt.first);
-                    if (testPlateIt != this->plates.end()) {
-                        std::shared_ptr<Plate> testPlate = testPlateIt->second;
-                        // try to get matrix
-                        Matrix3x3 toTestTransform;
-                        auto transformIt = testPlateTransforms.find(lastNearestIt.first);
-                        if (transformIt != testPlateTransforms.end()) {
-                            toTestTransform = transformIt->second;
-                        } else {
-                            // create the transform
-                            toTestTransform = math::matrixMul(math::transpose(testPlate->rotationMatrix), plate->rotationMatrix);
-                            testPlateTransforms[lastNearestIt.first] = toTestTransform;
-                        }
-                        Vec3 cellInTest = math::affineRotaionMulVec(toTestTransform, edgeCell->get_vertex()->get_vector());
-                        // check nearest
-                        uint32_t nearestCellIndex = this->getNearestGridIndex(cellInTest, lastNearestIt.second);
-                        
-                        // test if nearest is in target plate
-                        auto nearestCellIt = testPlate->cells.find(nearestCellIndex);
-                        if (nearestCellIt != testPlate->cells.end()) {
-                            std::shared_ptr<PlateCell> nearestCell = nearestCellIt->second;
-                            // check if this cell is too young
+            for (size_t begin = 0; begin < plate->edgeCells.size(); begin += edgeGrain) {
+                ranges.push_back({plate, begin, std::min(plate->edgeCells.size(), begin + edgeGrain)});
+            }
+        }
+        
+        std::vector<MomentumBuffer> momentum(ranges.size(), MomentumBuffer(*this->momentumTracker));
+        this->threadPool->parallelFor(ranges.size(), 1, [&](size_t rangeBegin, size_t rangeEnd) {
+            for (size_t range = rangeBegin; range < rangeEnd; range++) {
+                this->interactEdgeCells(ranges[range].plate, ranges[range].begin, ranges[range].end, timestep, momentum[range]);
+            }
+        });
+        for (auto&& buffer : momentum) {
+            this->momentumTracker->merge(buffer);
+        }
+    }
+    
+    void World::interactEdgeCells(std::shared_ptr<Plate> plate, size_t edgeBegin, size_t edgeEnd, wb_float timestep, MomentumBuffer& momentum){
+        // determine edge cell displacements, currently in the direction perpendicular to the closest triangle edge along the plate edge
+        for (size_t edge = edgeBegin; edge < edgeEnd; edge++) {
+            uint32_t edgeIndex = plate->edgeCells[edge];
+            PlateCell& edgeCell = *plate->cells.find(edgeIndex);
+            CellDeleteTarget deleteTarget(plate); // only plates less dense than this one
+            
+            for (auto&& lastNearestIt : edgeCell.edgeInfo->otherPlateLastNearest) {
+                // check the plate exists
+                auto testPlateIt = this->plates.find(lastNearestIt.first);
+                if (testPlateIt != this->plates.end()) {
+                    std::shared_ptr<Plate> testPlate = testPlateIt->second;
+                    const Matrix3x3& toTestTransform = this->plateTransform(*plate, *testPlate);
+                    Vec3 cellInTest = math::affineRotaionMulVec(toTestTransform, edgeCell.get_vertex()->get_vector());
+                    // check nearest
+                    uint32_t nearestCellIndex = this->getNearestGridIndex(cellInTest, lastNearestIt.second);
+                    
+                    // test if nearest is in target plate
+                    PlateCell* nearestCell = testPlate->cells.find(nearestCellIndex);
+                    if (nearestCell != nullptr) {
+                        // check if this cell is too young
 #warning "Not stable checking, allows for rifting between colliding plates to advance the least dense plate"
-                            if (deleteTarget.cell == nullptr && edgeCell->age < min_interaction_age && nearestCell->age < min_interaction_age && testPlate->densityOffset < deleteTarget.plate->densityOffset) {
-                                deleteTarget.cell = nearestCell;
-                                deleteTarget.plate = testPlate;
-                            } else
-                            // check delete target, any rock that ends up back at this cell should be moved to the nearest least dense plate
-                            if (testPlate->densityOffset < deleteTarget.plate->densityOffset && nearestCell->age > min_interaction_age) {
-                                deleteTarget.cell = nearestCell;
-                                deleteTarget.plate = testPlate;
+                        if (deleteTarget.cell == nullptr && edgeCell.age < min_interaction_age && nearestCell->age < min_interaction_age && testPlate->densityOffset < deleteTarget.plate->densityOffset) {
+                            deleteTarget.cell = nearestCell;
+                            deleteTarget.plate = testPlate;
+                        } else
+                        // check delete target, any rock that ends up back at this cell should be moved to the nearest least dense plate
+                        if (testPlate->densityOffset < deleteTarget.plate->densityOffset && nearestCell->age > min_interaction_age) {
+                            deleteTarget.cell = nearestCell;
+                            deleteTarget.plate = testPlate;
+                        }
+                        const Grid& grid = *this->worldGrid;
+                        uint32_t nearestVertex = nearestCell->get_vertex()->get_index();
+                        // need to find the two nearest neighbors
+                        std::pair<uint32_t, wb_float> closestNeighbor = std::make_pair(0, std::numeric_limits<wb_float>::infinity());
+                        std::pair<uint32_t, wb_float> secondClosestNeighbor = std::make_pair(0, std::numeric_limits<wb_float>::infinity());
+                        for (uint32_t neighborVertex : grid.get_neighbors(nearestVertex)) {
+                            wb_float testDistance = math::distanceBetween3Points(grid.get_position(neighborVertex), grid.get_position(nearestVertex));
+                            if (testDistance < closestNeighbor.second) {
+                                secondClosestNeighbor = closestNeighbor;
+                                closestNeighbor.first = neighborVertex;
+                                closestNeighbor.second = testDistance;
+                            } else if (testDistance < secondClosestNeighbor.second) {
+                                secondClosestNeighbor.first = neighborVertex;
+                                secondClosestNeighbor.second = testDistance;
                             }
-                            const GridVertex* nearestVertex = nearestCell->get_vertex();
-                            // need to find the two nearest neighbors
-                            std::pair<const GridVertex*, wb_float> closestNeighbor = std::make_pair(nullptr, std::numeric_limits<wb_float>::infinity());
-                            std::pair<const GridVertex*, wb_float> secondClosestNeighbor = std::make_pair(nullptr, std::numeric_limits<wb_float>::infinity());
-                            for (auto neighborVertexIt = nearestVertex->get_neighbors().begin(); neighborVertexIt != nearestVertex->get_neighbors().end(); neighborVertexIt++) {
-                                wb_float testDistance = math::distanceBetween3Points((*neighborVertexIt)->get_vector(), nearestVertex->get_vector());
-                                if (testDistance < closestNeighbor.second) {
-                                    secondClosestNeighbor = closestNeighbor;
-                                    closestNeighbor.first = (*neighborVertexIt);
-                                    closestNeighbor.second = testDistance;
-                                } else if (testDistance < secondClosestNeighbor.second) {
-                                    secondClosestNeighbor.first = (*neighborVertexIt);
-                                    secondClosestNeighbor.second = testDistance;
+                        }
+                        // find the edge in the direction of plate movement
+                        // angular cross position scaled to distance for timestep
+                        Vec3 pushVector = testPlate->pole.cross(cellInTest) * (testPlate->angularSpeed * timestep);
+                        // check the three possibilities
+                        
+                        const uint maxDepth = 2; // max loop depth
+                        bool exitFound = false;
+                        uint depth = 0;
+                        uint32_t pointA, pointB, pointC;
+                        pointA = nearestVertex;
+                        pointB = closestNeighbor.first;
+                        pointC = secondClosestNeighbor.first;
+                        
+                        Vec3 testPoint = cellInTest;
+                        wb_float netVCount = 0; // net number of pushVector vectors between origional cellInTest and the edge
+                        // closest and first neighbor
+                        
+                        
+                        bool checkPQ = true;
+                        
+                        Vec3 displacement; // displacement
+                        while (!exitFound && depth < maxDepth) {
+                            depth++;
+                            
+                            Vec3 intersectionPoint;
+                            wb_float vCount;
+                            bool validIntersection;
+                            uint8_t intersectingEdge;
+                            std::tie(intersectionPoint, vCount, validIntersection, intersectingEdge) = math::triangleIntersection(grid.get_position(pointA), grid.get_position(pointB), grid.get_position(pointC), testPoint, pushVector, checkPQ);
+                            // only check first PQ
+                            checkPQ = false;
+                            testPoint = intersectionPoint;
+                            if (validIntersection) {
+                                // swap based on insersecting edge
+                                if (intersectingEdge == 1 << 1) {
+                                    // intersecting on A - C
+                                    uint32_t temp = pointB;
+                                    pointB = pointC;
+                                    pointC = temp;
+                                } else if (intersectingEdge == 1 << 2) {
+                                    // intersectin on B - C
+                                    uint32_t temp = pointA;
+                                    pointA = pointC;
+                                    pointC = temp;
                                 }
+                                
+                                // increase net distance
+                                netVCount += vCount;
+                            } else {
+                                // something's funky!
+                                //throw std::logic_error("triangle edge intersection not found");
+                                displacement = pushVector * (netVCount + 0.333333); // push 1/3 of the movement outside of the test plate boundary
+                                break;
                             }
-                            // find the edge in the direction of plate movement
-                            // angular cross position scaled to distance for timestep
-                            Vec3 pushVector = testPlate->pole.cross(cellInTest) * (testPlate->angularSpeed * timestep);
-                            // check the three possibilities
                             
-                            const uint maxDepth = 2; // max loop depth
-                            bool exitFound = false;
-                            uint depth = 0;
-                            const GridVertex* pointA, * pointB, * pointC;
-                            pointA = nearestVertex;
-                            pointB = closestNeighbor.first;
-                            pointC = secondClosestNeighbor.first;
-                            
-                            Vec3 testPoint = cellInTest;
-                            wb_float netVCount = 0; // net number of pushVector vectors between origional cellInTest and the edge
-                            // closest and first neighbor
-                            
-                            
-                            bool checkPQ = true;
-                            
-                            Vec3 displacement; // displacement
-                            while (!exitFound && depth < maxDepth) {
-                                depth++;
-                                
-                                Vec3 intersectionPoint;
-                                wb_float vCount;
-                                bool validIntersection;
-                                uint8_t intersectingEdge;
-                                std::tie(intersectionPoint, vCount, validIntersection, intersectingEdge) = math::triangleIntersection(pointA->get_vector(), pointB->get_vector(), pointC->get_vector(), testPoint, pushVector, checkPQ);
-                                // only check first PQ
-                                checkPQ = false;
-                                testPoint = intersectionPoint;
-                                if (validIntersection) {
-                                    // swap based on insersecting edge
-                                    if (intersectingEdge == 1 << 1) {
-                                        // intersecting on A - C
-                                        const GridVertex *temp = pointB;
-                                        pointB = pointC;
-                                        pointC = temp;
-                                    } else if (intersectingEdge == 1 << 2) {
-                                        // intersectin on B - C
-                                        const GridVertex* temp = pointA;
-                                        pointA = pointC;
-                                        pointC = temp;
-                                    }
+                            // Intersection is now between A and B, need to check if they are on the edge
+                            if (testPlate->isEdgeCell(pointA)) {
+                                if (testPlate->isEdgeCell(pointB)) {
+                                    // we found an edge edge
+                                    exitFound = true;
                                     
-                                    // increase net distance
-                                    netVCount += vCount;
-                                } else {
-                                    // something's funky!
-                                    //throw std::logic_error("triangle edge intersection not found");
                                     displacement = pushVector * (netVCount + 0.333333); // push 1/3 of the movement outside of the test plate boundary
-                                    break;
                                 }
-                                
-                                // Intersection is now between A and B, need to check if they are on the edge
-                                auto aCheckIt = testPlate->edgeCells.find(pointA->get_index());
-                                if (aCheckIt != testPlate->edgeCells.end()) {
-                                    auto bCheckIt = testPlate->edgeCells.find(pointB->get_index());
-                                    if (bCheckIt != testPlate->edgeCells.end()) {
-                                        // we found an edge edge
-                                        exitFound = true;
-                                        
-                                        displacement = pushVector * (netVCount + 0.333333); // push 1/3 of the movement outside of the test plate boundary
-                                    }
-                                }
-                                if (!exitFound) {
-                                    // not on edge, need to find the next pair to check
-                                    size_t index = 0;
-                                    for (auto neighborIt = pointA->get_neighbors().begin(); neighborIt != pointA->get_neighbors().end(); neighborIt++, index++) {
-                                        if ((*neighborIt)->get_index() == pointB->get_index()) {
-                                            // must be the next or previous, whichever isn't the old pointC
-                                            if (pointA->get_neighbors()[(index + 1) % pointA->get_neighbors().size()]->get_index() == pointC->get_index()) {
-                                                pointC = pointA->get_neighbors()[(index - 1) % pointA->get_neighbors().size()];
-                                            } else {
-                                                pointC = pointA->get_neighbors()[(index + 1) % pointA->get_neighbors().size()];
-                                            }
-                                            break;
+                            }
+                            if (!exitFound) {
+                                // not on edge, need to find the next pair to check
+                                GridNeighbors ringA = grid.get_neighbors(pointA);
+                                for (size_t index = 0; index < ringA.size(); index++) {
+                                    if (ringA[index] == pointB) {
+                                        // must be the next or previous, whichever isn't the old pointC
+                                        if (ringA[(index + 1) % ringA.size()] == pointC) {
+                                            pointC = ringA[(index - 1) % ringA.size()];
+                                        } else {
+                                            pointC = ringA[(index + 1) % ringA.size()];
                                         }
+                                        break;
                                     }
                                 }
                             }
-                            if (netVCount != 0) {
-                                // add collision
-                                this->momentumTracker->addCollision(plate, testPlate);
-                                
-                                // store
-                                Vec3 displacementInSelf = math::affineRotaionMulVec(math::transpose(toTestTransform), displacement); // rotate back to self
-                                
-                                if (edgeCell->displacement == nullptr) {
-                                    edgeCell->displacement = std::make_shared<DisplacementInfo>();
-                                    //edgeCell->displacement->displacementLocation = edgeCell->get_vertex()->get_vector();
-                                }
-                                edgeCell->displacement->displacementLocation = edgeCell->displacement->displacementLocation + displacementInSelf;
+                        }
+                        if (netVCount != 0) {
+                            // add collision
+                            momentum.addCollision(plate, testPlate);
+                            
+                            // store
+                            Vec3 displacementInSelf = math::affineRotaionMulVec(this->plateTransform(*testPlate, *plate), displacement); // rotate back to self
+                            
+                            if (edgeCell.displacement == nullptr) {
+                                edgeCell.displacement = std::make_shared<DisplacementInfo>();
+                                //edgeCell.displacement->displacementLocation = edgeCell.get_vertex()->get_vector();
                             }
-                        } // end if nearest index is in test plate
-                    } // end if test plate exists
-                } // end for each last nearest on edge cell
-                
-                // move our cell
-                if (edgeCell->displacement != nullptr) {
-                    // check displacement length, if don't want to push past a neighbor cell
-                    Vec3 displacement = edgeCell->displacement->displacementLocation;
-                    if (displacement.length() > this->cellSmallAngle / 2) {
-                        displacement = displacement * (this->cellSmallAngle / 2 / displacement.length());
-                    }
-                    edgeCell->displacement->displacementLocation = displacement;
-                    //edgeCell->displacement->touched = true;
-                    
-                    // set delete target, will be nullptr if none found
-                    edgeCell->displacement->deleteTarget = deleteTarget.cell;
-                } else {
-                    edgeCell->displacement = std::make_shared<DisplacementInfo>();
-                    
-                    // set delete target, will be nullptr if none found
-                    edgeCell->displacement->deleteTarget = deleteTarget.cell;
+                            edgeCell.displacement->displacementLocation = edgeCell.displacement->displacementLocation + displacementInSelf;
+                        }
+                    } // end if nearest index is in test plate
+                } // end if test plate exists
+            } // end for each last nearest on edge cell
+            
+            // cells may move in storage before the delete happens, so the target is kept by handle
+            PlateCellHandle deleteHandle;
+            if (deleteTarget.cell != nullptr) {
+                deleteHandle = PlateCellHandle(deleteTarget.plate->id, deleteTarget.cell->get_vertex()->get_index());
+            }
+            
+            // move our cell
+            if (edgeCell.displacement != nullptr) {
+                // check displacement length, if don't want to push past a neighbor cell
+                Vec3 displacement = edgeCell.displacement->displacementLocation;
+                if (displacement.length() > this->cellSmallAngle / 2) {
+                    displacement = displacement * (this->cellSmallAngle / 2 / displacement.length());
                 }
+                edgeCell.displacement->displacementLocation = displacement;
+                //edgeCell.displacement->touched = true;
                 
-                // add momentum tranfer for cells that will delete
-                if (deleteTarget.cell != nullptr) {
-                    this->momentumTracker->transferMomentumOfCell(plate, deleteTarget.plate, edgeCell);
-                }
+                // set delete target, will be invalid if none found
+                edgeCell.displacement->deleteTarget = deleteHandle;
+            } else {
+                edgeCell.displacement = std::make_shared<DisplacementInfo>();
                 
-            } // end for each edge cell
-        } // end for each plate
+                // set delete target, will be invalid if none found
+                edgeCell.displacement->deleteTarget = deleteHandle;
+            }
+            
+            // add momentum tranfer for cells that will delete
+            if (deleteTarget.cell != nullptr) {
+                momentum.transferMomentumOfCell(plate, deleteTarget.plate, edgeCell);
+            }
+            
+        } // end for each edge cell
+    }
+    
+    
+    // share of a neighbor's displacement the relaxation passes on to the cell, by how directly the displacement points
+    // along the edge toward the cell against how it points along the cell's other edges, zero when it points away
+    static wb_float displacementShare(const Vec3* edgeDirections, uint32_t neighborCount, uint32_t neighborSlot, const Vec3& normalizedDisplacement) {
+        // cosine of the angle between the edge and the displacement, under 90 degrees when positive
+        wb_float cosAngle = edgeDirections[neighborSlot].dot(normalizedDisplacement);
+        // Nan's will be skipped should they arise
+        if (!(cosAngle > 0)) {
+            return 0;
+        }
+        wb_float weight = 0;
+        for (uint32_t testSlot = 0; testSlot < neighborCount; testSlot++) {
+            wb_float testCosAngle = edgeDirections[testSlot].dot(normalizedDisplacement);
+            if (testCosAngle > 0) {
+                weight += testCosAngle;
+            }
+        }
+        return cosAngle / weight;
     }
     
+    bool World::desiredDisplacement(Plate& plate, const PlateCell& cell, Vec3& desired) const {
+        // find center of current neighbors, move to that minus min displacement distance
+        bool displaced = false;
+        uint32_t cellIndex = cell.get_vertex()->get_index();
+        GridNeighbors cellNeighbors = this->worldGrid->get_neighbors(cellIndex);
+        // unit vectors from each neighbor toward the cell, precomputed by the grid
+        const Vec3* edgeDirections = this->worldGrid->get_edgeDirections(cellIndex);
+        uint32_t neighborCount = cellNeighbors.size();
+        for (uint32_t neighborSlot = 0; neighborSlot < neighborCount; neighborSlot++) {
+            const PlateCell* neighborCell = plate.cells.find(cellNeighbors[neighborSlot]);
+            if (neighborCell != nullptr) {
+                if (neighborCell->displacement != nullptr) {
+                    const Vec3& neighborDisplacement = neighborCell->displacement->displacementLocation;
+                    wb_float share = displacementShare(edgeDirections, neighborCount, neighborSlot, math::normalize3Vector(neighborDisplacement));
+                    if (share > 0) {
+                        desired = desired + neighborDisplacement * share;
+                        displaced = true;
+                    }
+                }
+            }
+        }
+        if (displaced) {
+            // remove the normal component so it's purpendicular to the sphere
+            desired = desired - cell.get_vertex()->get_vector() * cell.get_vertex()->get_vector().dot(desired);
+        }
+        return displaced;
+    }
     
     // currently a very basic displacement balancer, not forces
+    // Jacobi style, every cell reads last iteration's displacements, so cell ranges relax independently on the pool
+    // and a large plate spreads over every worker
+    //
+    // A cell whose neighbors kept their displacement computes the same thing it did last iteration, so the frontier
+    // mode only revisits neighbors of cells that actually changed. Iterations where nothing changes can't affect
+    // anything after them either, which is why stopping once the frontier empties matches the full sweep exactly
     void World::balanceInternalPlateForce(std::shared_ptr<Plate> plate, wb_float timestep) {
+        if (this->balanceMode == balanceSolve || this->balanceMode == balanceSolveValidate) {
+            this->solvePlateDisplacement(plate, timestep);
+            if (this->balanceMode == balanceSolveValidate) {
+                this->validatePlateDisplacement(plate, timestep);
+            }
+            return;
+        }
+        this->relaxPlateDisplacement(plate, timestep, this->balanceMode == balanceSweep);
+    }
+    
+    void World::relaxPlateDisplacement(std::shared_ptr<Plate> plate, wb_float timestep, bool sweep) {
         const wb_float decayFactor = exp(-0.051293*timestep);
         const wb_float minDisplacement = this->cellSmallAngle / 10;
+        const size_t cellGrain = 512;
+        size_t cellCount = plate->cells.size();
+        PlateCellStore::iterator cells = plate->cells.begin();
+        
+        // cells picking up their first displacement this iteration, created once nobody is reading the pointers
+        std::vector<uint8_t> newlyDisplaced(cellCount, 0);
+        std::vector<Vec3> newNextDisplacement(cellCount);
+        
+        // relax one cell into nextDisplacementLocation, true if it moved more than minDisplacement
+        auto stageCell = [&](uint32_t slot) -> bool {
+            PlateCell& cell = cells[slot];
+            Vec3 desired;
+            if (cell.edgeInfo != nullptr || !this->desiredDisplacement(*plate, cell, desired)) {
+                return false;
+            }
+            if (cell.displacement == nullptr) {
+                // a fresh displacement starts at zero
+                newlyDisplaced[slot] = 1;
+                if (desired.length() > minDisplacement) {
+                    newNextDisplacement[slot] = desired * decayFactor;
+                    return true;
+                }
+            } else {
+                Vec3 change = desired - cell.displacement->displacementLocation;
+                if(change.length() > minDisplacement) {
+                    cell.displacement->nextDisplacementLocation = desired * decayFactor;
+                    return true;
+                }
+            }
+            return false;
+        };
+        // copy next into current, true if the displacement neighbors see changed
+        auto commitCell = [&](uint32_t slot) -> bool {
+            PlateCell& cell = cells[slot];
+            if (newlyDisplaced[slot]) {
+                cell.displacement = std::make_shared<DisplacementInfo>();
+                cell.displacement->nextDisplacementLocation = newNextDisplacement[slot];
+                newlyDisplaced[slot] = 0;
+                newNextDisplacement[slot] = Vec3();
+            }
+            if (cell.displacement != nullptr) {
+                if (cell.edgeInfo == nullptr) {
+                    const Vec3& current = cell.displacement->displacementLocation;
+                    const Vec3& next = cell.displacement->nextDisplacementLocation;
+                    bool changed = current[0] != next[0] || current[1] != next[1] || current[2] != next[2];
+                    cell.displacement->displacementLocation = next;
+                    return changed;
+                }
+            }
+            return false;
+        };
+        
+        // frontier mode: slots to relax this iteration, starting from anything already displaced and its neighbors
+        std::vector<uint32_t> frontier;
+        std::vector<uint8_t> inFrontier;
+        auto addToFrontier = [&](uint32_t slot) {
+            if (!inFrontier[slot] && cells[slot].edgeInfo == nullptr) {
+                inFrontier[slot] = 1;
+                frontier.push_back(slot);
+            }
+        };
+        // grid adjacency is symmetric, so the cells that read a changed cell are its neighbors
+        auto addNeighborsToFrontier = [&](uint32_t slot) {
+            addToFrontier(slot);
+            for (uint32_t neighborIndex : this->worldGrid->get_neighbors(cells[slot].get_vertex()->get_index())) {
+                uint32_t neighborSlot = plate->cells.get_slot(neighborIndex);
+                if (neighborSlot != PlateCellStore::noSlot) {
+                    addToFrontier(neighborSlot);
+                }
+            }
+        };
+        if (!sweep) {
+            inFrontier.assign(cellCount, 0);
+            for (uint32_t slot = 0; slot < cellCount; slot++) {
+                if (cells[slot].displacement != nullptr) {
+                    addNeighborsToFrontier(slot);
+                }
+            }
+        }
+        std::vector<std::vector<uint32_t>> chunkChanged;
+        
         int i;
         bool hadMovement = true;
         for (i = 0; i < 100 && hadMovement; i++) {
-            hadMovement = false;
-            for (auto cellIt = plate->cells.begin(); cellIt != plate->cells.end(); cellIt++) {
-                std::shared_ptr<PlateCell>& cell = cellIt->second;
-                if (cell->edgeInfo == nullptr) {
-                    // find center of current neighbors, move to that minus min displacement distance
-                    
-                    Vec3 desiredDisplacement;
-                    bool displaced = false;
-                    for (auto&& neighborVertex : cell->get_vertex()->get_neighbors()) {
-                        auto neighborIt = plate->cells.find(neighborVertex->get_index());
-                        if (neighborIt != plate->cells.end()) {
-                            std::shared_ptr<PlateCell>& neighborCell = neighborIt->second;
-                            if (neighborCell->displacement != nullptr) {
-                                Vec3 normalizedDisplacement = math::normalize3Vector(neighborCell->displacement->displacementLocation);
-                                wb_float angle = math::angleBetweenUnitVectors(math::normalize3Vector(cell->get_vertex()->get_vector() - neighborCell->get_vertex()->get_vector()), normalizedDisplacement);
-                                // Nan's will be skipped should they arise
-                                if (angle < math::piOverTwo) {
-                                    wb_float weight = 0;
-                                    //  could skip angle computation for this vertex, also normalized vectors could be precomputed for ~ 6*8*3*vertexCount bytes
-                                    for (auto&& testVertex : cell->get_vertex()->get_neighbors()) {
-                                        wb_float testAngle = math::angleBetweenUnitVectors(math::normalize3Vector(cell->get_vertex()->get_vector() - testVertex->get_vector()), normalizedDisplacement);
-                                        if (testAngle < math::piOverTwo) {
-                                            weight+= cos(testAngle);
-                                        }
-                                    }
-                                    desiredDisplacement = desiredDisplacement + neighborCell->displacement->displacementLocation * (cos(angle) / weight);
-                                    displaced = true;
-                                }
-                            }
-                        }
+            std::atomic<bool> anyMovement(false);
+            if (sweep) {
+                this->threadPool->parallelFor(cellCount, cellGrain, [&](size_t slotBegin, size_t slotEnd) {
+                    bool chunkMovement = false;
+                    for (size_t slot = slotBegin; slot < slotEnd; slot++) {
+                        chunkMovement |= stageCell(slot);
                     }
-                    if (displaced) {
-                        if (cell->displacement == nullptr) {
-                            cell->displacement = std::make_shared<DisplacementInfo>();
-                        }
-                        
-                        // remove the normal component so it's purpendicular to the sphere
-                        desiredDisplacement = desiredDisplacement - cell->get_vertex()->get_vector() * cell->get_vertex()->get_vector().dot(desiredDisplacement);
-                        Vec3 change = desiredDisplacement - cell->displacement->displacementLocation;
-                        if(change.length() > minDisplacement) {
-                            cell->displacement->nextDisplacementLocation = desiredDisplacement * decayFactor;
-                            hadMovement = true;
+                    if (chunkMovement) {
+                        anyMovement.store(true, std::memory_order_relaxed);
+                    }
+                });
+                hadMovement = anyMovement.load();
+                
+                // update for next round;
+                this->threadPool->parallelFor(cellCount, cellGrain, [&](size_t slotBegin, size_t slotEnd) {
+                    for (size_t slot = slotBegin; slot < slotEnd; slot++) {
+                        commitCell(slot);
+                    }
+                });
+            } else {
+                if (frontier.empty()) {
+                    break;
+                }
+                size_t frontierSize = frontier.size();
+                chunkChanged.resize((frontierSize + cellGrain - 1) / cellGrain);
+                this->threadPool->parallelFor(frontierSize, cellGrain, [&](size_t begin, size_t end) {
+                    bool chunkMovement = false;
+                    for (size_t entry = begin; entry < end; entry++) {
+                        chunkMovement |= stageCell(frontier[entry]);
+                    }
+                    if (chunkMovement) {
+                        anyMovement.store(true, std::memory_order_relaxed);
+                    }
+                });
+                hadMovement = anyMovement.load();
+                
+                // update for next round, remembering who changed
+                this->threadPool->parallelFor(frontierSize, cellGrain, [&](size_t begin, size_t end) {
+                    std::vector<uint32_t>& changed = chunkChanged[begin / cellGrain];
+                    changed.clear();
+                    for (size_t entry = begin; entry < end; entry++) {
+                        if (commitCell(frontier[entry])) {
+                            changed.push_back(frontier[entry]);
                         }
                     }
+                });
+                
+                for (uint32_t slot : frontier) {
+                    inFrontier[slot] = 0;
                 }
-            }
-            
-            // update for next round;
-            for (auto cellIt = plate->cells.begin(); cellIt != plate->cells.end(); cellIt++) {
-                std::shared_ptr<PlateCell>& cell = cellIt->second;
-                if (cell->displacement != nullptr) {
-                    if (cell->edgeInfo == nullptr) {
-                        cell->displacement->displacementLocation = cell->displacement->nextDisplacementLocation;
-
+                frontier.clear();
+                for (size_t chunk = 0; chunk < chunkChanged.size(); chunk++) {
+                    for (uint32_t slot : chunkChanged[chunk]) {
+                        addNeighborsToFrontier(slot);
                     }
                 }
             }
@@ -1489,14 +1798,452 @@ namespace WorldBuilder {
     }
     
     
+    // Solves for the field the frontier and sweep relax toward. Interior cells within reach of a pushed edge cell become
+    // unknowns, reach being how many hops the largest push takes to decay under minDisplacement. Anything further out
+    // would come out under minDisplacement anyway and is left alone
+    //
+    // Each cell's weights depend on which way its neighbors move, so they are frozen at a guess, the linear system is
+    // solved, and the weights frozen again at the solution (Picard iteration). The first guess comes from plain
+    // decayed averaging, which has no weights to freeze. It stops once the relaxation's own update would move no cell
+    // by more than a tenth of what the relaxation itself bothers with
+    void World::solvePlateDisplacement(std::shared_ptr<Plate> plate, wb_float timestep) {
+        const wb_float decayFactor = exp(-0.051293*timestep);
+        const wb_float minDisplacement = this->cellSmallAngle / 10;
+        const uint32_t unsolved = std::numeric_limits<uint32_t>::max();
+        size_t cellCount = plate->cells.size();
+        PlateCellStore::iterator cells = plate->cells.begin();
+        
+        // pushed cells hold their displacement, find the largest push
+        wb_float largestPush = 0;
+        std::vector<uint32_t> frontier;
+        std::vector<uint32_t> unknownForSlot(cellCount, unsolved);
+        for (uint32_t slot = 0; slot < cellCount; slot++) {
+            if (cells[slot].edgeInfo != nullptr && cells[slot].displacement != nullptr) {
+                largestPush = std::max(largestPush, cells[slot].displacement->displacementLocation.length());
+                frontier.push_back(slot);
+            }
+        }
+        if (largestPush <= minDisplacement) {
+            return;
+        }
+        uint32_t reach = std::min<wb_float>(100, std::ceil(std::log(minDisplacement / largestPush) / std::log(decayFactor)));
+        
+        // breadth first out to reach, interior cells in the order found are the unknowns
+        std::vector<uint32_t> unknownSlots;
+        for (uint32_t depth = 0; depth < reach && !frontier.empty(); depth++) {
+            std::vector<uint32_t> nextFrontier;
+            for (uint32_t slot : frontier) {
+                for (uint32_t neighborIndex : this->worldGrid->get_neighbors(cells[slot].get_vertex()->get_index())) {
+                    uint32_t neighborSlot = plate->cells.get_slot(neighborIndex);
+                    if (neighborSlot != PlateCellStore::noSlot && unknownForSlot[neighborSlot] == unsolved && cells[neighborSlot].edgeInfo == nullptr) {
+                        unknownForSlot[neighborSlot] = unknownSlots.size();
+                        unknownSlots.push_back(neighborSlot);
+                        nextFrontier.push_back(neighborSlot);
+                    }
+                }
+            }
+            frontier.swap(nextFrontier);
+        }
+        
+        // every neighbor that can pass displacement on, the pushed edge cells and the other unknowns, found once
+        // reweighting then only recomputes shares. Unknown neighbors are couplings of the system in the same order
+        struct SolveNeighbor {
+            uint32_t neighborSlot; // in the cell's grid neighbors
+            uint32_t plateSlot;
+            uint32_t unknown; // unsolved for a pushed edge cell
+        };
+        std::vector<SolveNeighbor> solveNeighbors;
+        std::vector<uint32_t> solveNeighborOffsets(1, 0);
+        std::vector<uint32_t> couplingOffsets;
+        uint32_t couplingCount = 0;
+        std::vector<uint32_t> plateNeighborCounts;
+        DisplacementSystem system;
+        for (uint32_t slot : unknownSlots) {
+            uint32_t plateNeighbors = 0;
+            GridNeighbors neighbors = this->worldGrid->get_neighbors(cells[slot].get_vertex()->get_index());
+            system.addRow(cells[slot].get_vertex()->get_vector(), Vec3());
+            couplingOffsets.push_back(couplingCount);
+            for (uint32_t neighborSlot = 0; neighborSlot < neighbors.size(); neighborSlot++) {
+                uint32_t plateSlot = plate->cells.get_slot(neighbors[neighborSlot]);
+                if (plateSlot == PlateCellStore::noSlot) {
+                    continue;
+                }
+                plateNeighbors++;
+                const PlateCell& neighborCell = cells[plateSlot];
+                if (unknownForSlot[plateSlot] != unsolved) {
+                    system.addCoupling(unknownForSlot[plateSlot], 0);
+                    couplingCount++;
+                } else if (neighborCell.edgeInfo == nullptr || neighborCell.displacement == nullptr) {
+                    continue;
+                }
+                solveNeighbors.push_back({neighborSlot, plateSlot, unknownForSlot[plateSlot]});
+            }
+            solveNeighborOffsets.push_back(solveNeighbors.size());
+            plateNeighborCounts.push_back(plateNeighbors);
+        }
+        
+        // weights frozen at the current solution, plain averaging for the first guess
+        const size_t rowGrain = 1024;
+        auto freezeRows = [&](bool averaged) {
+            this->threadPool->parallelFor(unknownSlots.size(), rowGrain, [&](size_t rowBegin, size_t rowEnd) {
+                for (size_t row = rowBegin; row < rowEnd; row++) {
+                    PlateCell& cell = cells[unknownSlots[row]];
+                    const Vec3* edgeDirections = this->worldGrid->get_edgeDirections(cell.get_vertex()->get_index());
+                    uint32_t neighborCount = this->worldGrid->get_neighbors(cell.get_vertex()->get_index()).size();
+                    uint32_t coupling = couplingOffsets[row];
+                    Vec3 pushed;
+                    for (uint32_t entry = solveNeighborOffsets[row]; entry < solveNeighborOffsets[row + 1]; entry++) {
+                        const SolveNeighbor& neighbor = solveNeighbors[entry];
+                        const Vec3& guess = neighbor.unknown == unsolved ? cells[neighbor.plateSlot].displacement->displacementLocation : system.solution[neighbor.unknown];
+                        wb_float share = wb_float(1) / plateNeighborCounts[row];
+                        if (!averaged) {
+                            share = displacementShare(edgeDirections, neighborCount, neighbor.neighborSlot, math::normalize3Vector(guess));
+                        }
+                        if (neighbor.unknown == unsolved) {
+                            if (share > 0) {
+                                pushed = pushed + guess * share;
+                            }
+                        } else {
+                            system.set_weight(coupling++, share > 0 ? decayFactor * share : 0);
+                        }
+                    }
+                    const Vec3& normal = cell.get_vertex()->get_vector();
+                    pushed = pushed * decayFactor;
+                    system.set_rhs(row, pushed - normal * normal.dot(pushed));
+                }
+            });
+        };
+        
+        // With the weights frozen at a guess, the system's residual row for a cell is exactly the move the relaxation
+        // would still make there. The relaxation stops moving a cell once that falls under minDisplacement, this
+        // stops once no cell would move by a tenth of that
+        const wb_float updateTolerance = minDisplacement / 10;
+        const uint32_t linearIterations = 200;
+        const uint32_t maxReweights = 50;
+        freezeRows(true);
+        DisplacementSolveResult result = system.solve(*this->threadPool, 1e-2, linearIterations);
+        // each solve only has to get well under how far off the weights still are, the last one only measures
+        while (true) {
+            freezeRows(false);
+            DisplacementSolveResult linear = system.solve(*this->threadPool, 1e-8, result.reweights < maxReweights ? linearIterations : 0, 0.1);
+            result.iterations += linear.iterations;
+            result.residual = linear.initialResidual;
+            result.initialLargestRow = linear.initialLargestRow;
+            if (result.initialLargestRow <= updateTolerance || result.reweights == maxReweights) {
+                break;
+            }
+            result.reweights++;
+        }
+        
+        for (uint32_t unknown = 0; unknown < unknownSlots.size(); unknown++) {
+            PlateCell& cell = cells[unknownSlots[unknown]];
+            const Vec3& displacement = system.solution[unknown];
+            if (displacement.length() > minDisplacement) {
+                if (cell.displacement == nullptr) {
+                    cell.displacement = std::make_shared<DisplacementInfo>();
+                }
+                cell.displacement->displacementLocation = displacement;
+                cell.displacement->nextDisplacementLocation = displacement;
+            }
+        }
+        
+        std::lock_guard<std::mutex> guard(this->balanceResultLock);
+        this->balanceResult.unknowns += result.unknowns;
+        this->balanceResult.iterations = std::max(this->balanceResult.iterations, result.iterations);
+        this->balanceResult.reweights = std::max(this->balanceResult.reweights, result.reweights);
+        this->balanceResult.residual = std::max(this->balanceResult.residual, result.residual);
+        this->balanceResult.initialLargestRow = std::max(this->balanceResult.initialLargestRow, result.initialLargestRow);
+    }
+    
+    // the sweep leaves a cell alone once its update would move it less than minDisplacement, so it can sit a few
+    // minDisplacement short of the field it converges to
+    static const wb_float displacementValidationSlack = 4;
+    
+    // relaxes the plate again from where the solve started, with the sweep, and throws if the two fields disagree by
+    // more than the sweep's own slack, leaves the solved field in place
+    void World::validatePlateDisplacement(std::shared_ptr<Plate> plate, wb_float timestep) {
+        const wb_float minDisplacement = this->cellSmallAngle / 10;
+        size_t cellCount = plate->cells.size();
+        PlateCellStore::iterator cells = plate->cells.begin();
+        
+        // interior cells have no displacement before balancing, so clearing them restores the starting point
+        std::vector<std::shared_ptr<DisplacementInfo>> solved(cellCount);
+        for (uint32_t slot = 0; slot < cellCount; slot++) {
+            if (cells[slot].edgeInfo == nullptr) {
+                solved[slot] = cells[slot].displacement;
+                cells[slot].displacement = nullptr;
+            }
+        }
+        this->relaxPlateDisplacement(plate, timestep, true);
+        
+        wb_float largestDifference = 0;
+        for (uint32_t slot = 0; slot < cellCount; slot++) {
+            if (cells[slot].edgeInfo != nullptr) {
+                continue;
+            }
+            Vec3 solvedDisplacement = solved[slot] != nullptr ? solved[slot]->displacementLocation : Vec3();
+            Vec3 sweptDisplacement = cells[slot].displacement != nullptr ? cells[slot].displacement->displacementLocation : Vec3();
+            largestDifference = std::max(largestDifference, (solvedDisplacement - sweptDisplacement).length());
+            cells[slot].displacement = solved[slot];
+        }
+        if (!(largestDifference <= displacementValidationSlack * minDisplacement)) {
+            throw std::logic_error("Solved plate displacement disagrees with the sweep");
+        }
+    }
+    
+    /*************** Per Plate Tasks ***************/
+    void World::forEachPlate(std::function<void(std::shared_ptr<Plate>)> work){
+        TaskGroup plateTasks(*this->threadPool);
+        for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
+            std::shared_ptr<Plate> plate = plateIt->second;
+            plateTasks.run([&work, plate]() {
+                work(plate);
+            });
+        }
+        plateTasks.wait();
+    }
+    
     /*************** Plate Movement ***************/
     void World::movePlates(wb_float timestep){
+        this->occupancyCurrent = false;
         for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++)
         {
             std::shared_ptr<Plate> plate = plateIt->second;
             plate->move(timestep);
         }
+        this->updatePlateTransforms();
+        this->updatePlateBroadphase();
+    }
+    
+    static const uint32_t noTransformSlot = std::numeric_limits<uint32_t>::max();
+    
+    void World::updatePlateTransforms(){
+        size_t plateCount = this->plates.size();
+        this->transformSlots.assign(this->_nextPlateId, noTransformSlot);
+        std::vector<Plate*> slotPlates;
+        slotPlates.reserve(plateCount);
+        for (auto&& plateIt : this->plates) {
+            this->transformSlots[plateIt.first] = slotPlates.size();
+            slotPlates.push_back(plateIt.second.get());
+        }
+        this->transformPlateCount = plateCount;
+        this->plateTransforms.resize(plateCount * plateCount);
+        for (size_t from = 0; from < plateCount; from++) {
+            for (size_t to = 0; to < plateCount; to++) {
+                this->plateTransforms[from * plateCount + to] = math::matrixMul(slotPlates[to]->inverseRotation, slotPlates[from]->rotationMatrix);
+            }
+        }
+    }
+    
+    const Matrix3x3& World::plateTransform(const Plate& from, const Plate& to) const {
+        uint32_t fromSlot = from.id < this->transformSlots.size() ? this->transformSlots[from.id] : noTransformSlot;
+        uint32_t toSlot = to.id < this->transformSlots.size() ? this->transformSlots[to.id] : noTransformSlot;
+        if (fromSlot == noTransformSlot || toSlot == noTransformSlot) {
+            throw std::logic_error("Plate transform requested for a plate added since the last updatePlateTransforms.");
+        }
+        return this->plateTransforms[fromSlot * this->transformPlateCount + toSlot];
+    }
+    
+    void World::updatePlateBroadphase(){
+        size_t plateCount = this->transformPlateCount;
+        std::vector<std::shared_ptr<Plate>> slotPlates(plateCount);
+        for (auto&& plateIt : this->plates) {
+            slotPlates[this->transformSlots[plateIt.first]] = plateIt.second;
+        }
+        this->interactingPlates.assign(plateCount, std::vector<std::shared_ptr<Plate>>());
+        // ascending slots, so every list is in plate map order
+        for (size_t first = 0; first < plateCount; first++) {
+            Plate& firstPlate = *slotPlates[first];
+            for (size_t second = first + 1; second < plateCount; second++) {
+                Plate& secondPlate = *slotPlates[second];
+                Vec3 secondCenter = math::affineRotaionMulVec(this->plateTransforms[second * plateCount + first], secondPlate.center);
+                wb_float testAngle = math::angleBetweenUnitVectors(firstPlate.center, secondCenter);
+                // buffer zone for plates that just barely are close enough, the widest any consumer needs
+                if (testAngle < firstPlate.maxEdgeAngle + secondPlate.maxEdgeAngle + this->cellSmallAngle*3 || std::isnan(testAngle)) {
+                    this->interactingPlates[first].push_back(slotPlates[second]);
+                    this->interactingPlates[second].push_back(slotPlates[first]);
+                }
+            }
+        }
+    }
+    
+    const std::vector<std::shared_ptr<Plate>>& World::get_interactingPlates(const Plate& plate) const {
+        uint32_t slot = plate.id < this->transformSlots.size() ? this->transformSlots[plate.id] : noTransformSlot;
+        if (slot == noTransformSlot || slot >= this->interactingPlates.size()) {
+            throw std::logic_error("Interacting plates requested for a plate added since the last updatePlateBroadphase.");
+        }
+        return this->interactingPlates[slot];
+    }
+    
+    // occupancy keys order by distance, then plate slot, then cell index, so the smallest key is the nearest cell
+    // and ties break the same way whichever thread gets there first
+    static const uint64_t noOccupant = std::numeric_limits<uint64_t>::max();
+    static const uint32_t occupancySlotBits = 12;
+    static const size_t occupancyGrain = 4096;
+    
+    static uint64_t occupancyKey(wb_float distance, uint32_t slot, uint32_t cellIndex) {
+        // non negative floats order like their bits, the top 20 are plenty to pick the nearer cell
+        float narrowed = distance;
+        uint32_t distanceBits;
+        std::memcpy(&distanceBits, &narrowed, sizeof(distanceBits));
+        return ((uint64_t)(distanceBits >> occupancySlotBits) << (32 + occupancySlotBits)) | ((uint64_t)slot << 32) | cellIndex;
+    }
+    static uint32_t occupancySlot(uint64_t key) {
+        return (key >> 32) & ((1 << occupancySlotBits) - 1);
+    }
+    static uint32_t occupancyCell(uint64_t key) {
+        return (uint32_t)key;
+    }
+    
+    // covering plate entries, filled in any order, a set once the scatter is done
+    static const uint32_t coveringCapacity = 4;
+    static const uint32_t noCoveringPlate = std::numeric_limits<uint32_t>::max();
+    static const uint32_t crowdedCovering = noCoveringPlate - 1; // more plates than entries, held in the last entry
+    
+    static void addCoveringPlate(std::atomic<uint32_t>* entries, uint32_t plateId) {
+        for (uint32_t entry = 0; entry < coveringCapacity; entry++) {
+            uint32_t current = entries[entry].load(std::memory_order_relaxed);
+            while (current == noCoveringPlate && !entries[entry].compare_exchange_weak(current, plateId, std::memory_order_relaxed)) {
+            }
+            if (current == noCoveringPlate || current == plateId || current == crowdedCovering) {
+                return;
+            }
+        }
+        entries[coveringCapacity - 1].store(crowdedCovering, std::memory_order_relaxed);
+    }
+    
+    void World::updateOccupancy(){
+        size_t plateCount = this->transformPlateCount;
+        if (plateCount > (1 << occupancySlotBits)) {
+            throw std::logic_error("Too many plates to pack into occupancy keys.");
+        }
+        std::vector<std::shared_ptr<Plate>> slotPlates(plateCount);
+        for (auto&& plateIt : this->plates) {
+            slotPlates[this->transformSlots[plateIt.first]] = plateIt.second;
+        }
+        size_t vertexCount = this->worldGrid->verts_size();
+        this->threadPool->parallelFor(vertexCount, occupancyGrain, [this](size_t begin, size_t end) {
+            for (size_t index = begin; index < end; index++) {
+                this->occupancyKeys[index].store(noOccupant, std::memory_order_relaxed);
+                for (uint32_t entry = 0; entry < coveringCapacity; entry++) {
+                    this->coveringPlates[index * coveringCapacity + entry].store(noCoveringPlate, std::memory_order_relaxed);
+                }
+            }
+        });
+        
+        // scatter every cell to the world vertex nearest where it has moved, the nearest cell takes the vertex,
+        // and its plate is recorded as covering the vertex and the vertex's neighbors
+        struct OccupancyRange {
+            uint32_t slot;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<OccupancyRange> ranges;
+        for (uint32_t slot = 0; slot < plateCount; slot++) {
+            size_t cellCount = slotPlates[slot]->cells.size();
+            for (size_t begin = 0; begin < cellCount; begin += occupancyGrain) {
+                ranges.push_back({slot, begin, std::min(cellCount, begin + occupancyGrain)});
+            }
+        }
+        this->threadPool->parallelFor(ranges.size(), 1, [this, &ranges, &slotPlates](size_t begin, size_t end) {
+            std::vector<Vec3> positions;
+            std::vector<uint32_t> nearest;
+            for (size_t rangeIndex = begin; rangeIndex < end; rangeIndex++) {
+                const OccupancyRange& range = ranges[rangeIndex];
+                Plate& plate = *slotPlates[range.slot];
+                size_t count = range.end - range.begin;
+                positions.resize(count);
+                nearest.resize(count);
+                auto cellIt = plate.cells.begin() + range.begin;
+                for (size_t cell = 0; cell < count; cell++) {
+                    positions[cell] = plate.localToWorld(cellIt[cell].get_vertex()->get_vector());
+                }
+                this->worldGrid->nearestIndices(positions.data(), count, nearest.data());
+                for (size_t cell = 0; cell < count; cell++) {
+                    wb_float distance = math::distanceBetween3Points(positions[cell], this->worldGrid->get_position(nearest[cell]));
+                    uint64_t key = occupancyKey(distance, range.slot, cellIt[cell].get_vertex()->get_index());
+                    std::atomic<uint64_t>& occupant = this->occupancyKeys[nearest[cell]];
+                    uint64_t current = occupant.load(std::memory_order_relaxed);
+                    while (key < current && !occupant.compare_exchange_weak(current, key, std::memory_order_relaxed)) {
+                    }
+                    addCoveringPlate(&this->coveringPlates[nearest[cell] * coveringCapacity], plate.id);
+                    for (uint32_t neighborIndex : this->worldGrid->get_neighbors(nearest[cell])) {
+                        addCoveringPlate(&this->coveringPlates[neighborIndex * coveringCapacity], plate.id);
+                    }
+                }
+            }
+        });
+        
+        // unpack, a moved plate doesn't line up with the world grid so some vertices under it got no cell,
+        // those take the nearest cell of the plates around them when one covers the vertex
+        this->threadPool->parallelFor(vertexCount, occupancyGrain, [this, &slotPlates](size_t begin, size_t end) {
+            for (size_t index = begin; index < end; index++) {
+                uint64_t key = this->occupancyKeys[index].load(std::memory_order_relaxed);
+                const Vec3& position = this->worldGrid->get_position(index);
+                if (key == noOccupant) {
+                    for (uint32_t neighborIndex : this->worldGrid->get_neighbors(index)) {
+                        uint64_t neighborKey = this->occupancyKeys[neighborIndex].load(std::memory_order_relaxed);
+                        if (neighborKey == noOccupant) {
+                            continue;
+                        }
+                        uint32_t slot = occupancySlot(neighborKey);
+                        Plate& plate = *slotPlates[slot];
+                        Vec3 locationInLocal = plate.worldToLocal(position);
+                        uint32_t nearestIndex;
+                        if (!this->worldGrid->descendToNearest(locationInLocal, occupancyCell(neighborKey), 2, nearestIndex)) {
+                            nearestIndex = this->worldGrid->nearestIndex(locationInLocal);
+                        }
+                        if (plate.cells.contains(nearestIndex)) {
+                            wb_float distance = math::distanceBetween3Points(locationInLocal, this->worldGrid->get_position(nearestIndex));
+                            key = std::min(key, occupancyKey(distance, slot, nearestIndex));
+                        }
+                    }
+                }
+                PlateOccupant& occupant = this->occupancy[index];
+                if (key == noOccupant) {
+                    occupant = PlateOccupant();
+                    continue;
+                }
+                Plate& plate = *slotPlates[occupancySlot(key)];
+                occupant.cell = PlateCellHandle(plate.id, occupancyCell(key));
+                occupant.distance = math::distanceBetween3Points(position, plate.localToWorld(this->worldGrid->get_position(occupancyCell(key))));
+            }
+        });
+        this->occupancyCurrent = true;
     }
+    
+    // A plate covers a location when its cell nearest the location is in the plate. That cell has moved to within
+    // about a cell of the location and was scattered to the world vertex nearest where it moved, which puts it
+    // within two rings of the world vertex nearest the location. The scatter recorded it a ring out, this looks
+    // the other ring
+    bool World::nearbyPlates(uint32_t worldIndex, std::vector<uint32_t>& plateIds) const {
+        plateIds.clear();
+        auto addPlates = [this, &plateIds](uint32_t index) -> bool {
+            for (uint32_t entry = 0; entry < coveringCapacity; entry++) {
+                uint32_t plateId = this->coveringPlates[index * coveringCapacity + entry].load(std::memory_order_relaxed);
+                if (plateId == noCoveringPlate) {
+                    break;
+                }
+                if (plateId == crowdedCovering) {
+                    return false;
+                }
+                if (std::find(plateIds.begin(), plateIds.end(), plateId) == plateIds.end()) {
+                    plateIds.push_back(plateId);
+                }
+            }
+            return true;
+        };
+        if (!addPlates(worldIndex)) {
+            return false;
+        }
+        for (uint32_t neighborIndex : this->worldGrid->get_neighbors(worldIndex)) {
+            if (!addPlates(neighborIndex)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     wb_float World::randomPlateSpeed(){
         return randomSource->randomNormal(0.0095, 0.0038); // mean, stdev
     }
@@ -1504,15 +2251,33 @@ namespace WorldBuilder {
     
 /****************************** Info Getters ******************************/
     
+    const PlateOccupant& World::get_occupant(uint32_t worldIndex) const {
+        if (!this->occupancyCurrent) {
+            throw std::logic_error("Plate occupancy requested while plates are moving.");
+        }
+        return this->occupancy[worldIndex];
+    }
+    
+    const PlateOccupant& World::get_occupantAt(Vec3 location) const {
+        return this->get_occupant(this->worldGrid->nearestIndex(location));
+    }
+    
     LocationInfo World::get_locationInfo(Vec3 location) {
         LocationInfo info;
         wb_float distWeight = 0;
         
+        // only plates near the location can have a cell nearest it, without the occupancy try them all
+        std::vector<uint32_t> plateIds;
+        bool filtered = this->occupancyCurrent && this->nearbyPlates(this->worldGrid->nearestIndex(location), plateIds);
+        
         for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
             std::shared_ptr<Plate> plate = plateIt->second;
+            if (filtered && std::find(plateIds.begin(), plateIds.end(), plate->id) == plateIds.end()) {
+                continue;
+            }
             
             // check if we can interact
-            Vec3 locationInLocal = math::affineRotaionMulVec(math::transpose(plate->rotationMatrix), location);
+            Vec3 locationInLocal = plate->worldToLocal(location);
             wb_float testAngle = math::angleBetweenUnitVectors(locationInLocal, plate->center);
             if (plate->maxEdgeAngle == 0 || testAngle < plate->maxEdgeAngle || std::isnan(testAngle)) {
                 uint32_t hint = 0;
@@ -1520,32 +2285,32 @@ namespace WorldBuilder {
                     hint = plate->centerVertex->get_index();
                 }
                 uint32_t nearestIndex = this->getNearestGridIndex(locationInLocal, hint);
-                auto nearestIt = plate->cells.find(nearestIndex);
-                if (nearestIt != plate->cells.end()) {
+                const PlateCell* nearestCell = plate->cells.find(nearestIndex);
+                if (nearestCell != nullptr) {
                     // weight by distance
-                    wb_float weight = 1 / math::distanceBetween3Points(locationInLocal, nearestIt->second->get_vertex()->get_vector());
+                    wb_float weight = 1 / math::distanceBetween3Points(locationInLocal, nearestCell->get_vertex()->get_vector());
                     distWeight += weight;
 
-                    info.elevation += nearestIt->second->get_elevation() * weight;
-                    info.sediment += nearestIt->second->rock.sediment.get_thickness() * weight;
-                    info.tempurature += nearestIt->second->tempurature * weight;
-                    info.precipitation += nearestIt->second->precipitation * weight;
+                    info.elevation += nearestCell->get_elevation() * weight;
+                    info.sediment += nearestCell->rock.sediment.get_thickness() * weight;
+                    info.tempurature += nearestCell->tempurature * weight;
+                    info.precipitation += nearestCell->precipitation * weight;
                     info.plateId = plate->id;
                 }
 
                 // also loop through neighbors
-                for (auto vertIt: this->worldGrid->get_vertices().at(nearestIndex).get_neighbors()){
-                    auto neighborIt = plate->cells.find(vertIt->get_index());
-                    if (neighborIt != plate->cells.end()) {
+                for (uint32_t neighborIndex : this->worldGrid->get_neighbors(nearestIndex)){
+                    const PlateCell* neighborCell = plate->cells.find(neighborIndex);
+                    if (neighborCell != nullptr) {
                         // weight by distance
-                        wb_float weight = 1 / math::distanceBetween3Points(locationInLocal, neighborIt->second->get_vertex()->get_vector());
+                        wb_float weight = 1 / math::distanceBetween3Points(locationInLocal, neighborCell->get_vertex()->get_vector());
                         if (weight < this->cellSmallAngle) {
                             distWeight += weight;
 
-                            info.elevation += neighborIt->second->get_elevation() * weight;
-                            info.sediment += neighborIt->second->rock.sediment.get_thickness() * weight;
-                            info.tempurature += neighborIt->second->tempurature * weight;
-                            info.precipitation += neighborIt->second->precipitation * weight;
+                            info.elevation += neighborCell->get_elevation() * weight;
+                            info.sediment += neighborCell->rock.sediment.get_thickness() * weight;
+                            info.tempurature += neighborCell->tempurature * weight;
+                            info.precipitation += neighborCell->precipitation * weight;
                             info.plateId = plate->id;
                         }
                     }
@@ -1561,13 +2326,132 @@ namespace WorldBuilder {
         return info;
     }
     
+    void World::get_locationInfoBatch(const Vec3* locations, uint32_t count, LocationInfoBatch& results) {
+        results.elevation.assign(count, 0);
+        results.sediment.assign(count, 0);
+        results.tempurature.assign(count, 0);
+        results.precipitation.assign(count, 0);
+        results.plateId.assign(count, std::numeric_limits<uint32_t>::max());
+        std::vector<wb_float> distWeight(count, 0);
+        
+        // split into coordinate arrays for the batch kernels
+        std::vector<wb_float> xs(count), ys(count), zs(count);
+        for (uint32_t index = 0; index < count; index++) {
+            xs[index] = locations[index][0];
+            ys[index] = locations[index][1];
+            zs[index] = locations[index][2];
+        }
+        std::vector<wb_float> localXs(count), localYs(count), localZs(count), centerDots(count);
+        std::vector<uint32_t> candidates;
+        std::vector<Vec3> candidateLocations;
+        std::vector<uint32_t> candidateNearest;
+        candidates.reserve(count);
+        candidateLocations.reserve(count);
+        
+        // plates near each point, point p's are nearbyIds[nearbyOffsets[p], nearbyOffsets[p + 1]) unless it tries them all
+        std::vector<uint32_t> nearbyOffsets;
+        std::vector<uint32_t> nearbyIds;
+        std::vector<bool> nearbyAll;
+        if (this->occupancyCurrent) {
+            std::vector<uint32_t> worldNearest(count);
+            this->worldGrid->nearestIndices(locations, count, worldNearest.data());
+            nearbyOffsets.reserve(count + 1);
+            nearbyOffsets.push_back(0);
+            nearbyAll.resize(count);
+            std::vector<uint32_t> plateIds;
+            for (uint32_t index = 0; index < count; index++) {
+                nearbyAll[index] = !this->nearbyPlates(worldNearest[index], plateIds);
+                nearbyIds.insert(nearbyIds.end(), plateIds.begin(), plateIds.end());
+                nearbyOffsets.push_back(nearbyIds.size());
+            }
+        }
+        auto isNearby = [this, &nearbyOffsets, &nearbyIds, &nearbyAll](uint32_t index, uint32_t plateId) -> bool {
+            if (!this->occupancyCurrent || nearbyAll[index]) {
+                return true;
+            }
+            auto first = nearbyIds.begin() + nearbyOffsets[index];
+            auto last = nearbyIds.begin() + nearbyOffsets[index + 1];
+            return std::find(first, last, plateId) != last;
+        };
+        
+        for (auto plateIt = this->plates.begin(); plateIt != this->plates.end(); plateIt++) {
+            std::shared_ptr<Plate> plate = plateIt->second;
+            
+            // move every point into the plate's frame at once
+            math::affineRotaionMulBatch(plate->inverseRotation, xs.data(), ys.data(), zs.data(), count, localXs.data(), localYs.data(), localZs.data());
+            math::dotBatch(plate->center, localXs.data(), localYs.data(), localZs.data(), count, centerDots.data());
+            
+            // check if we can interact, comparing cosines rather than taking acos of every point
+            bool coversSphere = plate->maxEdgeAngle == 0 || plate->maxEdgeAngle >= 2 * math::piOverTwo;
+            wb_float minCenterDot = std::cos(plate->maxEdgeAngle);
+            candidates.clear();
+            candidateLocations.clear();
+            for (uint32_t index = 0; index < count; index++) {
+                if (!isNearby(index, plate->id)) {
+                    continue;
+                }
+                if (coversSphere || centerDots[index] > minCenterDot || std::isnan(centerDots[index])) {
+                    Vec3 locationInLocal;
+                    locationInLocal.coords[0] = localXs[index];
+                    locationInLocal.coords[1] = localYs[index];
+                    locationInLocal.coords[2] = localZs[index];
+                    candidates.push_back(index);
+                    candidateLocations.push_back(locationInLocal);
+                }
+            }
+            candidateNearest.resize(candidates.size());
+            this->worldGrid->nearestIndices(candidateLocations.data(), candidates.size(), candidateNearest.data());
+            
+            for (size_t candidate = 0; candidate < candidates.size(); candidate++) {
+                uint32_t index = candidates[candidate];
+                const Vec3& locationInLocal = candidateLocations[candidate];
+                uint32_t nearestIndex = candidateNearest[candidate];
+                const PlateCell* nearestCell = plate->cells.find(nearestIndex);
+                if (nearestCell != nullptr) {
+                    // weight by distance
+                    wb_float weight = 1 / math::distanceBetween3Points(locationInLocal, nearestCell->get_vertex()->get_vector());
+                    distWeight[index] += weight;
+                    
+                    results.elevation[index] += nearestCell->get_elevation() * weight;
+                    results.sediment[index] += nearestCell->rock.sediment.get_thickness() * weight;
+                    results.tempurature[index] += nearestCell->tempurature * weight;
+                    results.precipitation[index] += nearestCell->precipitation * weight;
+                    results.plateId[index] = plate->id;
+                }
+                
+                // also loop through neighbors
+                for (uint32_t neighborIndex : this->worldGrid->get_neighbors(nearestIndex)){
+                    const PlateCell* neighborCell = plate->cells.find(neighborIndex);
+                    if (neighborCell != nullptr) {
+                        // weight by distance
+                        wb_float weight = 1 / math::distanceBetween3Points(locationInLocal, neighborCell->get_vertex()->get_vector());
+                        if (weight < this->cellSmallAngle) {
+                            distWeight[index] += weight;
+                            
+                            results.elevation[index] += neighborCell->get_elevation() * weight;
+                            results.sediment[index] += neighborCell->rock.sediment.get_thickness() * weight;
+                            results.tempurature[index] += neighborCell->tempurature * weight;
+                            results.precipitation[index] += neighborCell->precipitation * weight;
+                            results.plateId[index] = plate->id;
+                        }
+                    }
+                }
+            }
+        }
+        
+        for (uint32_t index = 0; index < count; index++) {
+            results.elevation[index] = results.elevation[index] / distWeight[index];
+            results.sediment[index] = results.sediment[index] / distWeight[index];
+            results.tempurature[index] = results.tempurature[index] / distWeight[index];
+            results.precipitation[index] = results.precipitation[index] / distWeight[index];
+        }
+    }
+    
     RockColumn World::netRock() {
         RockColumn result;
         
         for(auto&& plateIt : this->plates) {
-            for (auto&& cellIt : plateIt.second->cells) {
-                result = accreteColumns(result, cellIt.second->rock);
-            }
+            result = accreteColumns(result, netColumn(plateIt.second->cells.get_layers()));
         }
         return result;
     }
@@ -1575,8 +2459,8 @@ namespace WorldBuilder {
     /*************** Validation  ***************/
     bool World::validate(){
         for (auto&& plateIt : this->plates) {
-            for (auto&& cellIt : plateIt.second->cells) {
-                if (cellIt.first != cellIt.second->get_vertex()->get_index()) {
+            for (auto&& cell : plateIt.second->cells) {
+                if (plateIt.second->cells.find(cell.get_vertex()->get_index()) != &cell) {
                     throw std::logic_error("Incorrect Id for cell");
                 }
             }
@@ -1587,39 +2471,19 @@ namespace WorldBuilder {
     /*************** Casting ***************/
     
     uint32_t World::getNearestGridIndex(Vec3 location, uint32_t hint) {
-        // check hint is valid
-        if (hint >= this->worldGrid->verts_size()) {
-            return std::numeric_limits<uint32_t>::max();
-        }
-        const GridVertex* currentNearest = &this->worldGrid->get_vertices()[hint];
-        const GridVertex* testSetNearest = currentNearest;
-        wb_float smallestSquareDistance = math::squareDistanceBetween3Points(location, currentNearest->get_vector());
-        // could loop for a very long time...
-        do {
-            float testDistance;
-            currentNearest = testSetNearest;
-            // loop neighbors
-            // bool closestFound = false;
-            for (std::vector<GridVertex*>::const_iterator vertexIt = currentNearest->get_neighbors().begin();
-                 vertexIt != currentNearest->get_neighbors().end();
-                 vertexIt++)
-            {
-                const GridVertex* vertex = (*vertexIt);
-                testDistance = math::squareDistanceBetween3Points(location, vertex->get_vector());
-                if (testDistance < smallestSquareDistance) {
-                    smallestSquareDistance = testDistance;
-                    testSetNearest = vertex;
-                }
+        // good hints are within a step or two, try them first
+        if (hint < this->worldGrid->verts_size()) {
+            uint32_t nearest;
+            if (this->worldGrid->descendToNearest(location, hint, 2, nearest)) {
+                return nearest;
             }
-        } while (currentNearest != testSetNearest);
-        
-        currentNearest = testSetNearest;
-        
-        return currentNearest->get_index();
+        }
+        // bad or missing hint, use the spatial index
+        return this->worldGrid->nearestIndex(location);
     }
     
     /*************** Constructors ***************/
-    World::World(Grid *theWorldGrid, std::shared_ptr<Random> random, WorldConfig config) : worldGrid(theWorldGrid), plates(10), randomSource(random), _nextPlateId(0), availableHotspotThickness(0){
+    World::World(Grid *theWorldGrid, std::shared_ptr<Random> random, WorldConfig config) : worldGrid(theWorldGrid), randomSource(random), threadPool(config.threadPool ? config.threadPool : ThreadPool::shared()), plates(10), _nextPlateId(0), transformPlateCount(0), occupancyKeys(theWorldGrid->verts_size()), occupancy(theWorldGrid->verts_size()), coveringPlates(theWorldGrid->verts_size() * coveringCapacity), occupancyCurrent(false), balanceMode(config.balanceMode), edgeUpdateMode(edgeIncremental), availableHotspotThickness(0){
         // set default rock column
         this->divergentOceanicColumn.root = RockSegment(84000.0, 3200.0);
         this->divergentOceanicColumn.oceanic = RockSegment(6000.0, 2890.0);
@@ -1642,7 +2506,7 @@ namespace WorldBuilder {
         
         // distance between cells in simulation
         // curently a multiple of cell small size
-        this->cellDistanceMeters = math::distanceBetween3Points(this->worldGrid->get_vertices()[0].get_vector(), this->worldGrid->get_vertices()[0].get_neighbors()[0]->get_vector()) * this->attributes.radius * 1000;
+        this->cellDistanceMeters = math::distanceBetween3Points(this->worldGrid->get_position(0), this->worldGrid->get_position(this->worldGrid->get_neighbors(0)[0])) * this->attributes.radius * 1000;
         
         // supercontinent stuff
         this->supercontinentCycleDuration = 0;
@@ -1651,9 +2515,9 @@ namespace WorldBuilder {
         
         // set cell small angle
         this->cellSmallAngle = std::numeric_limits<wb_float>::max();
-        for (auto&& vertex : theWorldGrid->get_vertices()) {
-            for (auto&& testVertex : vertex.get_neighbors()) {
-                wb_float testAngle = math::distanceBetween3Points(vertex.get_vector(), testVertex->get_vector());
+        for (uint32_t vertex = 0; vertex < theWorldGrid->verts_size(); vertex++) {
+            for (uint32_t testVertex : theWorldGrid->get_neighbors(vertex)) {
+                wb_float testAngle = math::distanceBetween3Points(theWorldGrid->get_position(vertex), theWorldGrid->get_position(testVertex));
                 if (testAngle < cellSmallAngle) {
                     this->cellSmallAngle = testAngle;
                 }
@@ -1665,9 +2529,9 @@ namespace WorldBuilder {
         firstPlate->angularSpeed = this->randomPlateSpeed();
         firstPlate->densityOffset = this->randomPlateDensityOffset();
         // add the initial cells to the plate
+        firstPlate->cells.reserve(theWorldGrid->verts_size());
         for (uint32_t index = 0; index < theWorldGrid->verts_size(); index++) {
-            std::shared_ptr<PlateCell> cell = std::make_shared<PlateCell>(&(theWorldGrid->get_vertices()[index]));
-            firstPlate->cells[index] = cell;
+            firstPlate->cells.insert(&(theWorldGrid->get_vertices()[index]));
         }
         
         this->plates.insert({firstPlate->id,firstPlate});
@@ -17,8 +17,11 @@
 #ifndef World_hpp
 #define World_hpp
 
+#include <atomic>
 #include <unordered_map>
 #include <limits>
+#include <mutex>
+#include <vector>
 
 #include "RockColumn.hpp"
 #include "Plate.hpp"
@@ -27,13 +30,42 @@
 #include "ErosionFlowGraph.hpp"
 #include "MomentumTracker.hpp"
 #include "VolcanicHotspot.hpp"
+#include "ThreadPool.hpp"
+#include "DisplacementSolver.hpp"
 
 namespace WorldBuilder {
 
+    // how balanceInternalPlateForce finds interior displacement, frontier and sweep give identical results
+    enum BalanceMode {
+        balanceFrontier,     // only revisit cells next to a cell that moved last iteration
+        balanceSweep,        // every cell every iteration, reference for validating the frontier and the solve
+        balanceSolve,        // the field frontier and sweep relax toward, solved directly, see DisplacementSolver.hpp
+        balanceSolveValidate // solve, then throws if the sweep from the same start lands somewhere else
+    };
+
     struct WorldConfig {
         wb_float waterDepth;
+        std::shared_ptr<ThreadPool> threadPool; // null for ThreadPool::shared()
+        BalanceMode balanceMode;
+        
+        WorldConfig() : waterDepth(0), balanceMode(balanceFrontier){};
     };
-
+    
+    // how updatePlateEdges finds edge cells and rifting targets
+    enum EdgeUpdateMode {
+        edgeIncremental, // only around cells the plate gained or lost since the last update
+        edgeRebuild,     // every cell every step
+        edgeValidate     // incremental, then throws if a rebuild would have found anything different
+    };
+    
+    // the plate cell lying over a world grid vertex, kept by World::updateOccupancy
+    struct PlateOccupant {
+        PlateCellHandle cell; // invalid where no plate covers the vertex
+        wb_float distance; // chord from the vertex to where the cell has moved
+        
+        PlateOccupant() : distance(std::numeric_limits<wb_float>::infinity()){};
+    };
+    
     struct LocationInfo {
         wb_float elevation;
         wb_float sediment;
@@ -43,6 +75,19 @@ namespace WorldBuilder {
         
         LocationInfo() : elevation(0), sediment(0), tempurature(0), precipitation(0), plateId(std::numeric_limits<uint32_t>::max()){};
     };
+    
+    // struct of arrays LocationInfo for many points, filled by World::get_locationInfoBatch
+    struct LocationInfoBatch {
+        std::vector<wb_float> elevation;
+        std::vector<wb_float> sediment;
+        std::vector<wb_float> tempurature;
+        std::vector<wb_float> precipitation;
+        std::vector<uint32_t> plateId;
+        
+        size_t size() const {
+            return elevation.size();
+        }
+    };
     /*************** Base World ***************/
     /*  Responsible for running the world forward through time
      *  This base implements common functions such as erosion and plate movement
@@ -53,6 +98,7 @@ namespace WorldBuilder {
     private:
         std::shared_ptr<Grid> worldGrid;
         std::shared_ptr<Random> randomSource;
+        std::shared_ptr<ThreadPool> threadPool;
         
         std::unordered_map<uint32_t, std::shared_ptr<Plate>> plates;
         uint32_t _nextPlateId;
@@ -60,11 +106,32 @@ namespace WorldBuilder {
             return _nextPlateId++;
         }
         
+        // rotation from one plate's local frame into another's for every pair of plates, rebuilt by updatePlateTransforms
+        std::vector<uint32_t> transformSlots; // by plate id
+        size_t transformPlateCount;
+        std::vector<Matrix3x3> plateTransforms; // slot x slot, row plate's local frame to column plate's
+        // by transform slot, the plates whose bounding caps come near it in plate map order, rebuilt by updatePlateBroadphase
+        std::vector<std::vector<std::shared_ptr<Plate>>> interactingPlates;
+        
+        // by world grid vertex, the moved plate cell nearest it, rebuilt by updateOccupancy once plates stop changing for the step
+        std::vector<std::atomic<uint64_t>> occupancyKeys; // distance, plate slot and cell index packed so the nearest cell wins an atomic min
+        std::vector<PlateOccupant> occupancy;
+        // by world grid vertex, coveringCapacity entries each, the id of every plate with a moved cell nearest the vertex
+        // or one of its neighbors
+        std::vector<std::atomic<uint32_t>> coveringPlates;
+        bool occupancyCurrent; // false from when plates move until the next updateOccupancy
+        
         RockColumn divergentOceanicColumn;
         WorldAttributes attributes;
         
         wb_float cellSmallAngle;
         
+        BalanceMode balanceMode;
+        std::mutex balanceResultLock;
+        DisplacementSolveResult balanceResult; // summed unknowns and worst plate of the last step, solve modes only
+        
+        EdgeUpdateMode edgeUpdateMode;
+        
         wb_float age;
         
         std::unordered_set<std::shared_ptr<VolcanicHotspot>> hotspots;
@@ -81,6 +148,10 @@ namespace WorldBuilder {
         //std::vector<std::shared_ptr<Plate>> deletedPlates; // TODO, find out why plates deleted from supercontinent break things
         void deletePlate(std::shared_ptr<Plate> plateToRemove);
         
+        // runs work on every plate as tasks on the pool, returns once all have finished
+        // work may write only to the plate it is given
+        void forEachPlate(std::function<void(std::shared_ptr<Plate>)> work);
+        
     public:
         // takes ownership of the grid
         World(Grid* theWorldGrid, std::shared_ptr<Random> randomSource, WorldConfig config);
@@ -96,11 +167,31 @@ namespace WorldBuilder {
         void balanceInternalPlateForce(std::shared_ptr<Plate> plate, wb_float timestep);
         
         void computeEdgeInteraction(wb_float timestep);
+        // computeEdgeInteraction for plate->edgeCells[edgeBegin, edgeEnd)
+        void interactEdgeCells(std::shared_ptr<Plate> plate, size_t edgeBegin, size_t edgeEnd, wb_float timestep, MomentumBuffer& momentum);
         
         void movePlates(wb_float timestep);
+        // rebuilds the pair table, after plates move or new plates are added
+        void updatePlateTransforms();
+        // takes points in from's local coordinates to to's
+        const Matrix3x3& plateTransform(const Plate& from, const Plate& to) const;
+        // tests every pair of bounding caps once, after the transforms or the caps change
+        void updatePlateBroadphase();
+        // other plates that may touch plate
+        const std::vector<std::shared_ptr<Plate>>& get_interactingPlates(const Plate& plate) const;
+        // scatters every plate's moved cells onto the world grid, after the transforms are current and cells stop changing
+        void updateOccupancy();
+        // ids of every plate that may cover a location nearest worldIndex, once each, false when too many plates crowd in to have
+        // been recorded and every plate has to be tried
+        bool nearbyPlates(uint32_t worldIndex, std::vector<uint32_t>& plateIds) const;
         
         /*************** Movement Aux ***************/
         wb_float randomPlateSpeed();
+        // where a cell's displaced neighbors push it, false if none of them do
+        bool desiredDisplacement(Plate& plate, const PlateCell& cell, Vec3& desired) const;
+        void relaxPlateDisplacement(std::shared_ptr<Plate> plate, wb_float timestep, bool sweep);
+        void solvePlateDisplacement(std::shared_ptr<Plate> plate, wb_float timestep);
+        void validatePlateDisplacement(std::shared_ptr<Plate> plate, wb_float timestep);
         
         
         
@@ -110,12 +201,18 @@ namespace WorldBuilder {
         void transitionPhase(wb_float timestep);
         
         void updatePlateEdges(std::shared_ptr<Plate> plate);
+        // edgeCells, riftingTargets and edge info from every cell, returns the sum of the cell positions
+        Vec3 rebuildPlateEdges(Plate& plate);
+        // the same, only for the cells logged in the plate's store and their neighbors
+        void updateChangedPlateEdges(Plate& plate);
+        // throws if a rebuild would give different edges or rifting targets
+        void validatePlateEdges(const Plate& plate) const;
         void knitPlates(std::shared_ptr<Plate> targetPlate);
         
         void renormalizeAllPlates();
         void renormalizePlate(std::shared_ptr<Plate> thePlate);
         
-        std::vector<std::shared_ptr<PlateCell>> riftPlate(std::shared_ptr<Plate> plate);
+        std::vector<uint32_t> riftPlate(std::shared_ptr<Plate> plate);
         
         void homeostasis(wb_float timestep);
         void updateSealevel();
@@ -166,8 +263,40 @@ namespace WorldBuilder {
         wb_float get_cellDistanceMeters() const {
             return this->cellDistanceMeters;
         }
+        std::shared_ptr<ThreadPool> get_threadPool() const {
+            return this->threadPool;
+        }
+        BalanceMode get_balanceMode() const {
+            return this->balanceMode;
+        }
+        EdgeUpdateMode get_edgeUpdateMode() const {
+            return this->edgeUpdateMode;
+        }
+        // true from the end of a transition phase until plates next move
+        bool hasOccupancy() const {
+            return this->occupancyCurrent;
+        }
+        // the plate cell over a world grid vertex, throws if the occupancy is not current
+        const PlateOccupant& get_occupant(uint32_t worldIndex) const;
+        // the plate cell over the world vertex nearest location
+        const PlateOccupant& get_occupantAt(Vec3 location) const;
+        // unknowns summed over plates, iterations and residual from the worst plate
+        DisplacementSolveResult get_balanceResult() {
+            std::lock_guard<std::mutex> guard(this->balanceResultLock);
+            return this->balanceResult;
+        }
+        
+        /*************** Setters ***************/
+        void set_balanceMode(BalanceMode mode) {
+            this->balanceMode = mode;
+        }
+        void set_edgeUpdateMode(EdgeUpdateMode mode) {
+            this->edgeUpdateMode = mode;
+        }
         
         LocationInfo get_locationInfo(Vec3 location);
+        // get_locationInfo for many points at once, one transform per plate for the whole batch
+        void get_locationInfoBatch(const Vec3* locations, uint32_t count, LocationInfoBatch& results);
         
         bool validate();
         
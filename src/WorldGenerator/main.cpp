@@ -7,7 +7,7 @@
 #include <iostream>
 
 #include <random>
-#include <thread>
+#include <string>
 
 #include <grpc/grpc.h>
 #include <grpc++/server.h>
@@ -21,6 +21,7 @@
 #include "BasicGenerator.hpp"
 #include "BombardmentGenerator.hpp"
 #include "World.hpp"
+#include "ThreadPool.hpp"
 
 using grpc::Server;
 using grpc::ServerBuilder;
@@ -32,8 +33,11 @@ using grpc::Status;
 
 class WorldBuilderImpl final : public api::WorldBuilder::Service {
 public:
-    explicit WorldBuilderImpl(std::string theTag){
+    explicit WorldBuilderImpl(std::string theTag, std::string theGridCacheDirectory, bool theReorderGrids, std::shared_ptr<WorldBuilder::ThreadPool> theThreadPool){
         this->tag = theTag;
+        this->gridCacheDirectory = theGridCacheDirectory;
+        this->reorderGrids = theReorderGrids;
+        this->threadPool = theThreadPool;
     }
     
     Status GenerateWorld(::grpc::ServerContext* context, ::grpc::ServerReaderWriter< ::api::SimulationInfo, ::api::SimulationRequest>* stream) override {
@@ -47,41 +51,90 @@ public:
         
         WorldBuilder::Grid *grid;
         stream->Read(&request);
-        if (!request.has_grid()) {
-            std::cout << "Expected Grid" << std::endl;
-            return Status::CANCELLED;
-        }
-
-        auto readGrid = request.grid();
-        if (readGrid.totalverts() == 0) {
-            return Status::CANCELLED;
+        if (request.has_initialization() && request.initialization().cachedgrid() != "") {
+            // grid uploaded by an earlier session
+            std::string cachePath = this->gridCachePath(request.initialization().cachedgrid());
+            if (cachePath == "") {
+                std::cout << "No grid cache for " << request.initialization().cachedgrid() << std::endl;
+                return Status::CANCELLED;
+            }
+            try {
+                grid = WorldBuilder::Grid::mapFile(cachePath);
+            } catch (std::runtime_error& e) {
+                std::cout << e.what() << std::endl;
+                return Status::CANCELLED;
+            }
+            std::cout << "Mapped cached grid with " << grid->verts_size() << " vertices" << std::endl;
+        } else if (request.has_initialization() && request.initialization().gridsubdivisions() > 0) {
+            // no grid upload, build it here unless a previous session left it in the cache
+            uint32_t level = request.initialization().gridsubdivisions();
+            std::string cachePath = this->gridCachePath("icosphere-" + std::to_string(level) + (this->reorderGrids ? "-hilbert" : ""));
+            grid = nullptr;
+            if (cachePath != "") {
+                try {
+                    grid = WorldBuilder::Grid::mapFile(cachePath);
+                    std::cout << "Mapped cached grid with " << grid->verts_size() << " vertices" << std::endl;
+                } catch (std::runtime_error& e) {
+                    // not cached yet
+                }
+            }
+            if (grid == nullptr) {
+                auto gridStart = std::chrono::high_resolution_clock::now();
+                try {
+                    grid = WorldBuilder::Grid::icosphere(level);
+                } catch (std::invalid_argument& e) {
+                    std::cout << e.what() << std::endl;
+                    return Status::CANCELLED;
+                }
+                std::chrono::duration<double> gridDuration = std::chrono::high_resolution_clock::now() - gridStart;
+                std::cout << "Generated grid with " << grid->verts_size() << " vertices in " << gridDuration.count() << " seconds." << std::endl;
+                if (this->reorderGrids) {
+                    grid->reorderForLocality();
+                }
+                this->saveGrid(grid, cachePath);
+            }
         } else {
-            gridVertexCount = readGrid.totalverts();
-            grid = new WorldBuilder::Grid(readGrid.totalverts());
-            grid->addGrpcGridPart(&readGrid);
-            currentGridCount += readGrid.vertices_size();
-        }
-        // read remaining RequestAsyncClientStreaming
-        while (currentGridCount < gridVertexCount) {
-            stream->Read(&request);
             if (!request.has_grid()) {
                 std::cout << "Expected Grid" << std::endl;
                 return Status::CANCELLED;
             }
-            
+
             auto readGrid = request.grid();
-            grid->addGrpcGridPart(&readGrid);
-            currentGridCount += readGrid.vertices_size();
-        }
-        
-        // finish grid creation
-        grid->buildCenters();
+            std::string cachePath = this->gridCachePath(readGrid.cachename());
+            if (readGrid.totalverts() == 0) {
+                return Status::CANCELLED;
+            } else {
+                gridVertexCount = readGrid.totalverts();
+                grid = new WorldBuilder::Grid(readGrid.totalverts());
+                grid->addGrpcGridPart(&readGrid);
+                currentGridCount += readGrid.vertices_size();
+            }
+            // read remaining RequestAsyncClientStreaming
+            while (currentGridCount < gridVertexCount) {
+                stream->Read(&request);
+                if (!request.has_grid()) {
+                    std::cout << "Expected Grid" << std::endl;
+                    return Status::CANCELLED;
+                }
+                
+                auto readGrid = request.grid();
+                grid->addGrpcGridPart(&readGrid);
+                currentGridCount += readGrid.vertices_size();
+            }
+            
+            // finish grid creation
+            grid->finishLoading();
+            if (this->reorderGrids) {
+                grid->reorderForLocality();
+            }
+            this->saveGrid(grid, cachePath);
 
-        // get the initialization values
-        stream->Read(&request);
-        if (!request.has_initialization()){
-            std::cout << "No initialization sent" << std::endl;
-            return Status::CANCELLED;
+            // get the initialization values
+            stream->Read(&request);
+            if (!request.has_initialization()){
+                std::cout << "No initialization sent" << std::endl;
+                return Status::CANCELLED;
+            }
         }
 
         auto init = request.initialization();
@@ -89,6 +142,21 @@ public:
         WorldBuilder::WorldConfig config;
 
         config.waterDepth = init.waterdepth();
+        config.threadPool = this->threadPool; // every session shares the same workers
+        switch (init.balancemode()) {
+            case api::Initialization::SWEEP:
+                config.balanceMode = WorldBuilder::balanceSweep;
+                break;
+            case api::Initialization::SOLVE:
+                config.balanceMode = WorldBuilder::balanceSolve;
+                break;
+            case api::Initialization::SOLVE_VALIDATE:
+                config.balanceMode = WorldBuilder::balanceSolveValidate;
+                break;
+            default:
+                config.balanceMode = WorldBuilder::balanceFrontier;
+                break;
+        }
         
         std::random_device rd;
         // TODO: add seed to initialization
@@ -123,52 +191,32 @@ public:
             
             std::chrono::time_point<std::chrono::high_resolution_clock> renderStart;
             std::chrono::time_point<std::chrono::high_resolution_clock> renderEnd;
-            // split rendering among cores
+            // split rendering among the pool
             renderStart = std::chrono::high_resolution_clock::now();
-            auto renderPart = [grid, runner](size_t startIndex, size_t end_index, std::shared_ptr<std::vector<WorldBuilder::LocationInfo>> storage) {
-                for (size_t index = startIndex; index < end_index; index++) {
-                    WorldBuilder::LocationInfo info = runner.get_world()->get_locationInfo(grid->get_vertices()[index].get_vector());
-                    storage->push_back(info);
-                }
-            };
+            std::shared_ptr<WorldBuilder::ThreadPool> pool = runner.get_world()->get_threadPool();
+            size_t renderGrain = pool->evenGrain(grid->verts_size());
+            std::vector<WorldBuilder::LocationInfoBatch> results((grid->verts_size() + renderGrain - 1) / renderGrain);
+            pool->parallelFor(grid->verts_size(), renderGrain, [grid, &runner, &results, renderGrain](size_t startIndex, size_t endIndex) {
+                runner.get_world()->get_locationInfoBatch(grid->get_positions() + startIndex, endIndex - startIndex, results[startIndex / renderGrain]);
+            });
             
-            unsigned int concurentThreadMax = std::thread::hardware_concurrency();
-            //concurentThreadMax = 1; // force single threaded
-            
-            uint32_t vertsPerThread = grid->get_vertices().size() / concurentThreadMax;
-            uint32_t leftOverVerts = grid->get_vertices().size() % concurentThreadMax;
-            
-            
-            std::vector<std::shared_ptr<std::vector<WorldBuilder::LocationInfo>>> results;
-            std::vector<std::thread> threads;
-            
-            size_t currentStart = 0;
-            for (unsigned int threadIndex = 0; threadIndex < concurentThreadMax; threadIndex++) {
-                size_t vertsToDo = vertsPerThread;
-                if (threadIndex < leftOverVerts) {
-                    vertsToDo++;
-                }
-                std::shared_ptr<std::vector<WorldBuilder::LocationInfo>> threadResults = std::make_shared<std::vector<WorldBuilder::LocationInfo>>();
-                threadResults->reserve(vertsToDo);
-                results.push_back(threadResults);
-                
-                threads.push_back(std::thread(renderPart, currentStart, currentStart + vertsToDo, threadResults));
-                
-                currentStart += vertsToDo;
+            // chunks come back in grid order
+            WorldBuilder::LocationInfoBatch rendered;
+            for (const WorldBuilder::LocationInfoBatch& part : results) {
+                rendered.elevation.insert(rendered.elevation.end(), part.elevation.begin(), part.elevation.end());
+                rendered.sediment.insert(rendered.sediment.end(), part.sediment.begin(), part.sediment.end());
+                rendered.tempurature.insert(rendered.tempurature.end(), part.tempurature.begin(), part.tempurature.end());
+                rendered.precipitation.insert(rendered.precipitation.end(), part.precipitation.begin(), part.precipitation.end());
+                rendered.plateId.insert(rendered.plateId.end(), part.plateId.begin(), part.plateId.end());
             }
-            
-            // join our threads and get the results to the grpc object
-            auto resultsIt = results.begin();
-            for (auto threadIt = threads.begin(); threadIt != threads.end(); threadIt++, resultsIt++) {
-                threadIt->join();
-                // results are now done for this thread, add them
-                for (auto&& infoIt = (*resultsIt)->begin(); infoIt != (*resultsIt)->end(); infoIt++) {
-                    info.add_elevations(infoIt->elevation);
-                    info.add_sediment(infoIt->sediment);
-                    info.add_plates(infoIt->plateId);
-                    info.add_tempurature(infoIt->tempurature);
-                    info.add_precipitation(infoIt->precipitation);
-                }
+            // add them to the grpc object in the order the client knows the grid by
+            for (uint32_t originalIndex = 0; originalIndex < grid->verts_size(); originalIndex++) {
+                uint32_t index = grid->get_vertexForOriginal(originalIndex);
+                info.add_elevations(rendered.elevation[index]);
+                info.add_sediment(rendered.sediment[index]);
+                info.add_plates(rendered.plateId[index]);
+                info.add_tempurature(rendered.tempurature[index]);
+                info.add_precipitation(rendered.precipitation[index]);
             }
             
 //            for (auto vertexIt = grid->get_vertices().begin(); vertexIt != grid->get_vertices().end(); vertexIt++)
@@ -201,6 +249,30 @@ public:
     
 private:
     std::string tag;
+    std::string gridCacheDirectory; // empty to disable caching
+    bool reorderGrids; // renumber grids along a space filling curve, output stays in upload order
+    std::shared_ptr<WorldBuilder::ThreadPool> threadPool;
+
+    // path for a cache entry, empty if caching is off or the name could escape the directory
+    std::string gridCachePath(const std::string& name) {
+        if (this->gridCacheDirectory == "" || name == "" || name[0] == '.' || name.find('/') != std::string::npos) {
+            return "";
+        }
+        return this->gridCacheDirectory + "/" + name + ".wbgrid";
+    }
+
+    void saveGrid(const WorldBuilder::Grid* grid, const std::string& cachePath) {
+        if (cachePath == "") {
+            return;
+        }
+        try {
+            grid->writeFile(cachePath);
+            std::cout << "Saved grid to " << cachePath << std::endl;
+        } catch (std::runtime_error& e) {
+            // the session can continue without the cache
+            std::cout << e.what() << std::endl;
+        }
+    }
     
 };
 
@@ -208,7 +280,33 @@ private:
 
 int main(int argc, const char * argv[]) {
     std::string server_address("0.0.0.0:18082");
-    WorldBuilderImpl service("chicken");
+    // optional directory for memory mapped grid files, shared by every server on the machine
+    // --locality-order renumbers grid vertices for cache locality
+    // --threads n sizes the worker pool shared by every session, defaults to one per hardware thread
+    std::string gridCacheDirectory = "";
+    bool reorderGrids = false;
+    uint32_t threadCount = 0;
+    for (int argIndex = 1; argIndex < argc; argIndex++) {
+        std::string arg = argv[argIndex];
+        if (arg == "--locality-order") {
+            reorderGrids = true;
+        } else if (arg == "--threads") {
+            // a whole number, 0 for one per hardware thread
+            std::string count = argIndex + 1 < argc ? argv[++argIndex] : "";
+            if (count.empty() || count.size() > 4 || count.find_first_not_of("0123456789") != std::string::npos) {
+                std::cout << "Bad thread count \"" << count << "\"" << std::endl;
+                std::cout << "Usage: " << argv[0] << " [--locality-order] [--threads n] [grid cache directory]" << std::endl;
+                return 1;
+            }
+            threadCount = std::stoul(count);
+        } else {
+            gridCacheDirectory = arg;
+        }
+    }
+    std::shared_ptr<WorldBuilder::ThreadPool> threadPool = std::make_shared<WorldBuilder::ThreadPool>(threadCount);
+    WorldBuilder::ThreadPool::set_shared(threadPool);
+    std::cout << "Running on " << threadPool->get_threadCount() << " threads" << std::endl;
+    WorldBuilderImpl service("chicken", gridCacheDirectory, reorderGrids, threadPool);
     
     ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
@@ -7,7 +7,13 @@
 
 #include "math.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <random>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace WorldBuilder {
     namespace math {
@@ -150,6 +156,45 @@ namespace WorldBuilder {
             return result;
         }; // affineRotationMulVec
         
+        void affineRotaionMulBatch(const Matrix3x3& rotationTransform, const wb_float* xs, const wb_float* ys, const wb_float* zs, size_t count, wb_float* outXs, wb_float* outYs, wb_float* outZs) {
+            size_t index = 0;
+#ifdef __AVX2__
+            static_assert(sizeof(wb_float) == sizeof(double), "AVX2 batch kernels assume double precision wb_float");
+            __m256d m00 = _mm256_set1_pd(rotationTransform.rows[0][0]), m01 = _mm256_set1_pd(rotationTransform.rows[0][1]), m02 = _mm256_set1_pd(rotationTransform.rows[0][2]);
+            __m256d m10 = _mm256_set1_pd(rotationTransform.rows[1][0]), m11 = _mm256_set1_pd(rotationTransform.rows[1][1]), m12 = _mm256_set1_pd(rotationTransform.rows[1][2]);
+            __m256d m20 = _mm256_set1_pd(rotationTransform.rows[2][0]), m21 = _mm256_set1_pd(rotationTransform.rows[2][1]), m22 = _mm256_set1_pd(rotationTransform.rows[2][2]);
+            for (; index + 4 <= count; index += 4) {
+                __m256d x = _mm256_loadu_pd(xs + index);
+                __m256d y = _mm256_loadu_pd(ys + index);
+                __m256d z = _mm256_loadu_pd(zs + index);
+                _mm256_storeu_pd(outXs + index, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m00, x), _mm256_mul_pd(m01, y)), _mm256_mul_pd(m02, z)));
+                _mm256_storeu_pd(outYs + index, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m10, x), _mm256_mul_pd(m11, y)), _mm256_mul_pd(m12, z)));
+                _mm256_storeu_pd(outZs + index, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m20, x), _mm256_mul_pd(m21, y)), _mm256_mul_pd(m22, z)));
+            }
+#endif
+            for (; index < count; index++) {
+                outXs[index] = rotationTransform.rows[0][0] * xs[index] + rotationTransform.rows[0][1] * ys[index] + rotationTransform.rows[0][2] * zs[index];
+                outYs[index] = rotationTransform.rows[1][0] * xs[index] + rotationTransform.rows[1][1] * ys[index] + rotationTransform.rows[1][2] * zs[index];
+                outZs[index] = rotationTransform.rows[2][0] * xs[index] + rotationTransform.rows[2][1] * ys[index] + rotationTransform.rows[2][2] * zs[index];
+            }
+        }; // affineRotaionMulBatch
+        
+        void dotBatch(const Vec3& vector, const wb_float* xs, const wb_float* ys, const wb_float* zs, size_t count, wb_float* outDots) {
+            size_t index = 0;
+#ifdef __AVX2__
+            __m256d vx = _mm256_set1_pd(vector[0]), vy = _mm256_set1_pd(vector[1]), vz = _mm256_set1_pd(vector[2]);
+            for (; index + 4 <= count; index += 4) {
+                __m256d x = _mm256_loadu_pd(xs + index);
+                __m256d y = _mm256_loadu_pd(ys + index);
+                __m256d z = _mm256_loadu_pd(zs + index);
+                _mm256_storeu_pd(outDots + index, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, vx), _mm256_mul_pd(y, vy)), _mm256_mul_pd(z, vz)));
+            }
+#endif
+            for (; index < count; index++) {
+                outDots[index] = xs[index] * vector[0] + ys[index] * vector[1] + zs[index] * vector[2];
+            }
+        }; // dotBatch
+        
         float vectorMul(Vec3 a, Vec3 b){
             return a[0]*b[0]+a[1]*b[1]+a[2]*b[2];
         }
@@ -162,6 +207,41 @@ namespace WorldBuilder {
             return result;
         }
         
+        Quaternion quaternionAboutAxis(Vec3 axis, wb_float angleRadians){
+            Vec3 normalizedAxis = normalize3Vector(axis);
+            wb_float sinHalf = std::sin(angleRadians / 2);
+            return Quaternion(std::cos(angleRadians / 2), normalizedAxis[0] * sinHalf, normalizedAxis[1] * sinHalf, normalizedAxis[2] * sinHalf);
+        }
+        
+        Quaternion quaternionMul(Quaternion a, Quaternion b){
+            return Quaternion(a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z,
+                              a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y,
+                              a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x,
+                              a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w);
+        }
+        
+        Quaternion normalizeQuaternion(Quaternion q){
+            wb_float length = std::sqrt(q.w*q.w + q.x*q.x + q.y*q.y + q.z*q.z);
+            if (length == 0 || std::isnan(length)) {
+                return Quaternion();
+            }
+            return Quaternion(q.w / length, q.x / length, q.y / length, q.z / length);
+        }
+        
+        Matrix3x3 rotationMatrixFromQuaternion(Quaternion q){
+            Matrix3x3 rotationMatrix;
+            rotationMatrix.rows[0].coords[0] = 1 - 2*(q.y*q.y + q.z*q.z);
+            rotationMatrix.rows[0].coords[1] = 2*(q.x*q.y - q.z*q.w);
+            rotationMatrix.rows[0].coords[2] = 2*(q.x*q.z + q.y*q.w);
+            rotationMatrix.rows[1].coords[0] = 2*(q.x*q.y + q.z*q.w);
+            rotationMatrix.rows[1].coords[1] = 1 - 2*(q.x*q.x + q.z*q.z);
+            rotationMatrix.rows[1].coords[2] = 2*(q.y*q.z - q.x*q.w);
+            rotationMatrix.rows[2].coords[0] = 2*(q.x*q.z - q.y*q.w);
+            rotationMatrix.rows[2].coords[1] = 2*(q.y*q.z + q.x*q.w);
+            rotationMatrix.rows[2].coords[2] = 1 - 2*(q.x*q.x + q.y*q.y);
+            return rotationMatrix;
+        }
+        
         Matrix3x3 matrixMul(Matrix3x3 a, Matrix3x3 b){
             Matrix3x3 result;
             result.rows[0].coords[0] = vectorMul(a[0], b.column(0));
@@ -180,6 +260,91 @@ namespace WorldBuilder {
             return result;
         }
         
+        // caps below are an axis and the cosine of their angle, a point is inside when axis.point >= cosine
+        static const wb_float capTolerance = 1e-12;
+        
+        // Vec3::cross has the wrong z component, kept for the callers that depend on it
+        static Vec3 crossProduct(const Vec3 a, const Vec3 b){
+            Vec3 result;
+            result.coords[0] = a[1]*b[2] - a[2]*b[1];
+            result.coords[1] = a[2]*b[0] - a[0]*b[2];
+            result.coords[2] = a[0]*b[1] - a[1]*b[0];
+            return result;
+        }
+        
+        // normalize3VectorWithScale gives up on lengths far larger than the cross products of neighboring cells
+        static bool normalizeCapAxis(const Vec3 vector, Vec3& axis){
+            wb_float length = vector.length();
+            if (!(length > capTolerance)) {
+                return false;
+            }
+            axis = vector * (1 / length);
+            return true;
+        }
+        
+        // smallest cap with both points on its rim
+        static bool capThroughTwo(const Vec3 a, const Vec3 b, Vec3& axis, wb_float& cosine){
+            if (!normalizeCapAxis(a + b, axis)) {
+                return false; // antipodal
+            }
+            cosine = axis.dot(a);
+            return cosine > 0;
+        }
+        
+        // the cap with all three points on its rim, falls back to the widest pair when they lie on one great circle
+        static bool capThroughThree(const Vec3 a, const Vec3 b, const Vec3 c, Vec3& axis, wb_float& cosine){
+            if (!normalizeCapAxis(crossProduct(b - a, c - a), axis)) {
+                wb_float ab = a.dot(b), ac = a.dot(c), bc = b.dot(c);
+                if (ab <= ac && ab <= bc) {
+                    return capThroughTwo(a, b, axis, cosine);
+                }
+                return ac <= bc ? capThroughTwo(a, c, axis, cosine) : capThroughTwo(b, c, axis, cosine);
+            }
+            if (axis.dot(a) < 0) {
+                axis = axis * -1;
+            }
+            cosine = axis.dot(a);
+            return cosine > 0;
+        }
+        
+        bool minimalBoundingCap(std::vector<Vec3> points, Vec3& center, wb_float& angle){
+            if (points.empty()) {
+                return false;
+            }
+            // the expected linear time needs a random order, grid order is spatially coherent which is close to the worst case
+            std::minstd_rand shuffleSource(points.size());
+            std::shuffle(points.begin(), points.end(), shuffleSource);
+            
+            Vec3 axis = points[0];
+            wb_float cosine = 1;
+            auto inside = [&axis, &cosine](const Vec3& point) {
+                return axis.dot(point) >= cosine - capTolerance;
+            };
+            for (size_t i = 1; i < points.size(); i++) {
+                if (inside(points[i])) {
+                    continue;
+                }
+                axis = points[i];
+                cosine = 1;
+                for (size_t j = 0; j < i; j++) {
+                    if (inside(points[j])) {
+                        continue;
+                    }
+                    if (!capThroughTwo(points[i], points[j], axis, cosine)) {
+                        return false;
+                    }
+                    for (size_t k = 0; k < j; k++) {
+                        if (!inside(points[k]) && !capThroughThree(points[i], points[j], points[k], axis, cosine)) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            center = axis;
+            angle = std::acos(std::min((wb_float)1, cosine));
+            return true;
+        }
+        
         wb_float circleIntersectionArea(wb_float distance, wb_float radius){
             if (distance > 2*radius) {
                 return 0;
@@ -187,6 +352,52 @@ namespace WorldBuilder {
             return 2*radius*radius*acos(distance/(2*radius)) - 1/2 * distance * std::sqrt(4*radius*radius - distance*distance);
         }
         
+        // sampled against s = sqrt(2 - distance / radius), the area goes like sqrt(2 - distance / radius) at the rim
+        // which is linear in s, so linear interpolation stays accurate right out to where the circles stop touching
+        static const size_t overlapTableSize = 1024;
+        
+        struct OverlapTable {
+            wb_float step;
+            wb_float inverseStep;
+            std::vector<wb_float> areas;
+            
+            OverlapTable() : step(std::sqrt((wb_float)2) / (overlapTableSize - 1)), inverseStep(1 / step), areas(overlapTableSize + 1) {
+                for (size_t sample = 0; sample < overlapTableSize; sample++) {
+                    wb_float s = sample * step;
+                    areas[sample] = circleIntersectionArea(std::max((wb_float)0, 2 - s*s), 1);
+                }
+                // past the end, so interpolation never needs a bounds check
+                areas[overlapTableSize] = areas[overlapTableSize - 1];
+            }
+        };
+        
+        static const OverlapTable& overlapTable(){
+            static const OverlapTable table;
+            return table;
+        }
+        
+        static inline wb_float tabulatedOverlap(const OverlapTable& table, wb_float squareDistance, wb_float radius){
+            wb_float normalizedDistance = std::sqrt(squareDistance) / radius;
+            if (!(normalizedDistance <= 2)) {
+                return 0;
+            }
+            wb_float position = std::sqrt(2 - normalizedDistance) * table.inverseStep;
+            size_t sample = (size_t)position;
+            wb_float blend = position - sample;
+            return radius * radius * (table.areas[sample] + (table.areas[sample + 1] - table.areas[sample]) * blend);
+        }
+        
+        wb_float overlapWeight(wb_float squareDistance, wb_float radius){
+            return tabulatedOverlap(overlapTable(), squareDistance, radius);
+        }
+        
+        void overlapWeightBatch(const wb_float* squareDistances, size_t count, wb_float radius, wb_float* weights){
+            const OverlapTable& table = overlapTable();
+            for (size_t index = 0; index < count; index++) {
+                weights[index] = tabulatedOverlap(table, squareDistances[index], radius);
+            }
+        }
+        
         std::tuple<Vec3, wb_float, bool> edgeIntersection(Vec3 p, Vec3 q, Vec3 a, Vec3 v) {
             Vec3 n = a-p;
             auto normScaleX = normalize3VectorWithScale(q - p);
@@ -12,6 +12,7 @@
 #include <utility>
 #include <cmath>
 #include <tuple>
+#include <vector>
 #include "Defines.h"
 
 namespace WorldBuilder {
@@ -82,6 +83,14 @@ namespace WorldBuilder {
         };
     };
     
+    // unit quaternion rotation, w + xi + yj + zk
+    struct Quaternion{
+        wb_float w, x, y, z;
+        
+        Quaternion() : w(1), x(0), y(0), z(0){};
+        Quaternion(wb_float ourW, wb_float ourX, wb_float ourY, wb_float ourZ) : w(ourW), x(ourX), y(ourY), z(ourZ){};
+    };
+    
     namespace math {
         const wb_float piOverTwo = 1.5707963267948966192313216916397514420985847;
 
@@ -98,9 +107,30 @@ namespace WorldBuilder {
         Matrix3x3 matrixMul(Matrix3x3 a, Matrix3x3 b);
         Matrix3x3 transpose(Matrix3x3 a);
         
+        // same rotation as rotationMatrixAboutAxis
+        Quaternion quaternionAboutAxis(const Vec3 axis, const wb_float angleRadians);
+        // rotation by b then a, matches matrixMul(a, b) on the matching matrices
+        Quaternion quaternionMul(const Quaternion a, const Quaternion b);
+        Quaternion normalizeQuaternion(const Quaternion q);
+        Matrix3x3 rotationMatrixFromQuaternion(const Quaternion q);
+        
         Vec3 affineRotaionMulVec(const Matrix3x3 rotationTransform, const Vec3 vector);
         
+        // batch kernels over struct of arrays points, AVX2 when available
+        // same arithmetic as the single vector versions, outputs may not alias inputs
+        void affineRotaionMulBatch(const Matrix3x3& rotationTransform, const wb_float* xs, const wb_float* ys, const wb_float* zs, size_t count, wb_float* outXs, wb_float* outYs, wb_float* outZs);
+        void dotBatch(const Vec3& vector, const wb_float* xs, const wb_float* ys, const wb_float* zs, size_t count, wb_float* outDots);
+        
         wb_float circleIntersectionArea(wb_float distance, wb_float radius);
+        // circleIntersectionArea from a table, without the acos, takes the square distance between the centers
+        // area scales with radius^2, so one table sampled at radius 1 serves every cell size and grid resolution
+        wb_float overlapWeight(wb_float squareDistance, wb_float radius);
+        void overlapWeightBatch(const wb_float* squareDistances, size_t count, wb_float radius, wb_float* weights);
+        
+        // smallest spherical cap holding every unit vector in points, angle is from the center to the cap's rim
+        // false when they don't fit in a cap narrower than a hemisphere, or there are none
+        // Welzl's incremental algorithm over a fixed shuffle of the points, expected linear time
+        bool minimalBoundingCap(std::vector<Vec3> points, Vec3& center, wb_float& angle);
         
         // returns the intercept point, numver of |v| between a and intercept, and whether or not the intercept lies between p and q (otherwise its on on side or the other)
         std::tuple<Vec3, wb_float, bool> edgeIntersection(Vec3 p, Vec3 q, Vec3 a, Vec3 v);